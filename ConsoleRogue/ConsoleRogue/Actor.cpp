@@ -1,4 +1,4 @@
-#include "GameState.h"
+#include "GameCore.h"
 
 Actor::Actor(ACTOR_TYPE type, std::array<int, 2> position) : type(type) {
 	this->position[0] = position[0];
@@ -12,4 +12,9 @@ Actor::Actor(ACTOR_TYPE type, std::array<int, 2> position) : type(type) {
 	range = 1;
 	speedLimit = 100;
 	type = ACTOR_TYPE::_count; // Just for initialization
-}
\ No newline at end of file
+}
+
+void Actor::moveActor(const int& xChange, const int& yChange) {
+	this->position[0] += xChange;
+	this->position[1] += yChange;
+}
@@ -0,0 +1,74 @@
+#include "GameCore.h"
+
+ActorTable::ActorTable(std::pmr::memory_resource* memory) : positionX(memory), positionY(memory), energyBase(memory), speedLimit(memory),
+	health(memory), damage(memory), armor(memory), range(memory), type(memory), ids(memory), slots(memory) {}
+
+int ActorTable::add(const Actor& actor, const int64_t& now) {
+	int id = int(this->slots.size());
+	this->slots.push_back(this->size());
+	this->positionX.push_back(actor.position[0]);
+	this->positionY.push_back(actor.position[1]);
+	this->energyBase.push_back(now - (actor.speed % actor.speedLimit + actor.speedLimit) % actor.speedLimit);
+	this->speedLimit.push_back(actor.speedLimit);
+	this->health.push_back(actor.health);
+	this->damage.push_back(actor.damage);
+	this->armor.push_back(actor.armor);
+	this->range.push_back(actor.range);
+	this->type.push_back(actor.type);
+	this->ids.push_back(id);
+	return id;
+}
+
+// The last enemy takes over the freed slot - turn order between enemies doesn't matter, so there is no need to shift the rest
+void ActorTable::remove(const int& id) {
+	int slot = this->slots[id];
+	int last = this->size() - 1;
+	this->positionX[slot] = this->positionX[last];
+	this->positionY[slot] = this->positionY[last];
+	this->energyBase[slot] = this->energyBase[last];
+	this->speedLimit[slot] = this->speedLimit[last];
+	this->health[slot] = this->health[last];
+	this->damage[slot] = this->damage[last];
+	this->armor[slot] = this->armor[last];
+	this->range[slot] = this->range[last];
+	this->type[slot] = this->type[last];
+	this->ids[slot] = this->ids[last];
+	this->slots[this->ids[slot]] = slot;
+	this->slots[id] = -1;
+
+	this->positionX.pop_back();
+	this->positionY.pop_back();
+	this->energyBase.pop_back();
+	this->speedLimit.pop_back();
+	this->health.pop_back();
+	this->damage.pop_back();
+	this->armor.pop_back();
+	this->range.pop_back();
+	this->type.pop_back();
+	this->ids.pop_back();
+}
+
+void ActorTable::clear() {
+	this->positionX.clear();
+	this->positionY.clear();
+	this->energyBase.clear();
+	this->speedLimit.clear();
+	this->health.clear();
+	this->damage.clear();
+	this->armor.clear();
+	this->range.clear();
+	this->type.clear();
+	this->ids.clear();
+	this->slots.clear();
+}
+
+Actor ActorTable::get(const int& slot, const int64_t& now) const {
+	Actor actor(this->type[slot], { this->positionX[slot], this->positionY[slot] });
+	actor.speed = this->energyAt(slot, now);
+	actor.speedLimit = this->speedLimit[slot];
+	actor.health = this->health[slot];
+	actor.damage = this->damage[slot];
+	actor.armor = this->armor[slot];
+	actor.range = this->range[slot];
+	return actor;
+}
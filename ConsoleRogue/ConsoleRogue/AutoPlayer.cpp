@@ -0,0 +1,90 @@
+#include "GameCore.h"
+#include <vector>
+
+static const int xChanges[4] = { 0, 0, -1, 1 };
+static const int yChanges[4] = { -1, 1, 0, 0 };
+static const PLAYER_ACTION moves[4] = { PLAYER_ACTION::MOVE_UP, PLAYER_ACTION::MOVE_DOWN, PLAYER_ACTION::MOVE_LEFT, PLAYER_ACTION::MOVE_RIGHT };
+
+PLAYER_ACTION AutoPlayer::chooseAction(const Simulation& simulation) {
+	const Map& playArea = simulation.playArea;
+	const Player& player = *simulation.player;
+	if (playArea.level->nearestVisibleEnemy(playArea, player.position[0], player.position[1], player.range) != -1) {
+		return PLAYER_ACTION::INTERRACT;
+	}
+
+	int pickupGoal, exitGoal, unexploredGoal;
+	int start;
+	for (int distance = reach; ; distance *= 2) {
+		start = this->search(playArea, player, distance, pickupGoal, exitGoal, unexploredGoal);
+		bool wholeMap = this->window.width == playArea.width && this->window.height == playArea.height;
+		if (pickupGoal != -1 || exitGoal != -1 || unexploredGoal != -1 || wholeMap) {
+			break;
+		}
+	}
+
+	int goal = pickupGoal != -1 ? pickupGoal : (exitGoal != -1 ? exitGoal : unexploredGoal);
+	if (goal == start && (pickupGoal != -1 || exitGoal != -1)) {
+		return PLAYER_ACTION::INTERRACT; // Right next to it
+	}
+	if (goal != -1 && goal != start) {
+		while (this->parents[goal] != start) { // Walk back to the first step
+			goal = this->parents[goal];
+		}
+		int xChange = this->window.xOf(goal) - player.position[0];
+		int yChange = this->window.yOf(goal) - player.position[1];
+		for (int direction = 0; direction < 4; ++direction) {
+			if (xChanges[direction] == xChange && yChanges[direction] == yChange) {
+				return moves[direction];
+			}
+		}
+	}
+	this->fallbackDirection = (this->fallbackDirection + 1) % 4;
+	return moves[this->fallbackDirection];
+}
+
+int AutoPlayer::search(const Map& playArea, const Player& player, const int& reach, int& pickupGoal, int& exitGoal, int& unexploredGoal) {
+	// Search outwards over the floor the player has seen. Goblins are walked through - they don't stay put anyway
+	this->window = MapWindow(playArea.width, playArea.height, player.position[0], player.position[1], reach);
+	int start = this->window.indexOf(player.position[0], player.position[1]);
+	this->parents.assign(this->window.size(), -1);
+	this->frontier.clear();
+	this->parents[start] = start;
+	this->frontier.push_back(start);
+	pickupGoal = -1;
+	exitGoal = -1;
+	unexploredGoal = -1;
+	for (size_t head = 0; head < this->frontier.size() && pickupGoal == -1; ++head) {
+		int cell = this->frontier[head];
+		int x = this->window.xOf(cell);
+		int y = this->window.yOf(cell);
+		for (int direction = 0; direction < 4; ++direction) {
+			int nextX = x + xChanges[direction];
+			int nextY = y + yChanges[direction];
+			if (!this->window.contains(nextX, nextY)) {
+				continue;
+			}
+			if (!playArea.visibility.isSeen(nextX, nextY)) {
+				if (unexploredGoal == -1) {
+					unexploredGoal = cell; // Standing here would show something new
+				}
+				continue;
+			}
+			char tile = playArea.tileAt(nextX, nextY);
+			if (TileProperties::has(tile, TileProperties::isPickup)) {
+				if (TileProperties::pickupType(tile) != PICKUP_TYPE::EXIT) {
+					pickupGoal = cell;
+				}
+				else if (exitGoal == -1) {
+					exitGoal = cell;
+				}
+				continue;
+			}
+			int next = this->window.indexOf(nextX, nextY);
+			if (this->parents[next] == -1 && !playArea.isTerrainBlocker(nextX, nextY)) {
+				this->parents[next] = cell;
+				this->frontier.push_back(next);
+			}
+		}
+	}
+	return start;
+}
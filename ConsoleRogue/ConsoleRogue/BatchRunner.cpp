@@ -0,0 +1,212 @@
+// Plays many AutoPlayer games at once and reports how they went, as JSON
+// Usage: ConsoleRogueBatch [--games N] [--threads N] [--seed N] [--max-turns N] [--width N] [--height N] [--output file.json]
+// Every game owns all of its state, so workers share nothing but the counter handing out game numbers
+#include "GameCore.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// Turn times counted in buckets that widen with the time - eight to every power of two, so a percentile read back is within 1/16 of the truth
+// A fixed size however many turns are played, where keeping every time could take hundreds of megabytes
+struct LatencyHistogram {
+	static constexpr int subBuckets = 8;
+	static constexpr int subBucketBits = 3;
+	std::array<long long, 64 * subBuckets> counts{};
+	long long total = 0;
+
+	static int bucketOf(const long long& nanoseconds) {
+		uint64_t value = uint64_t(std::max(nanoseconds, 0ll));
+		if (value < subBuckets) {
+			return int(value); // Exact below that
+		}
+		int exponent = subBucketBits;
+		while ((value >> (exponent + 1)) != 0) {
+			++exponent;
+		}
+		return exponent * subBuckets + int((value >> (exponent - subBucketBits)) & (subBuckets - 1));
+	}
+	// The middle of the range a bucket counts
+	static long long valueOf(const int& bucket) {
+		if (bucket < subBuckets) {
+			return bucket;
+		}
+		int exponent = bucket / subBuckets;
+		long long width = 1ll << (exponent - subBucketBits);
+		return (subBuckets + bucket % subBuckets) * width + width / 2;
+	}
+	void add(const long long& nanoseconds) {
+		++counts[bucketOf(nanoseconds)];
+		++total;
+	}
+	void merge(const LatencyHistogram& other) {
+		for (size_t bucket = 0; bucket < counts.size(); ++bucket) {
+			counts[bucket] += other.counts[bucket];
+		}
+		total += other.total;
+	}
+	// The time of the turn that would be at index total * percent / 100 if they were all sorted
+	long long percentile(const int& percent) const {
+		long long rank = total * percent / 100;
+		long long below = 0;
+		for (size_t bucket = 0; bucket < counts.size(); ++bucket) {
+			below += counts[bucket];
+			if (below > rank) {
+				return valueOf(int(bucket));
+			}
+		}
+		return 0; // Nothing was counted
+	}
+};
+
+// What one worker saw - merged once every worker is done
+// Workers update theirs every turn, so each starts on a cache line of its own - neighbours in the vector would otherwise share one
+struct alignas(64) BatchTally {
+	int won = 0;
+	int died = 0;
+	int turnLimit = 0; // Still running at --max-turns - the bot can take longer than that to clear a floor of a huge map
+	long long turns = 0;
+	std::array<long long, WINNING_FLOOR + 1> turnsOnFloor{}; // Only from games that finished, a cut off game would make its last floor look short
+	std::array<int, WINNING_FLOOR + 1> gamesOnFloor{}; // How many finished games got to play each floor
+	LatencyHistogram turnNanoseconds;
+};
+
+static void playGames(std::atomic<int>& nextGame, const int& games, const uint64_t& seed, const int& maxTurns, const int& width, const int& height, BatchTally& tally) {
+	std::vector<GameEvent> events; // Reused every turn of every game
+	for (int game = nextGame++; game < games; game = nextGame++) {
+		Simulation simulation(RandomService::deriveSeed(seed, game), width, height, FLOOR_GENERATION::ON_CALLING_THREAD); // A prefetch thread per game would compete with the other workers
+		AutoPlayer bot;
+		int floor = -1;
+		std::array<long long, WINNING_FLOOR + 1> turnsOnFloor{};
+		std::array<int, WINNING_FLOOR + 1> gamesOnFloor{};
+		for (int turn = 0; turn < maxTurns && simulation.status == GAME_STATUS::RUNNING; ++turn) {
+			int difficulty = simulation.playArea.level->difficultyLevel;
+			if (difficulty != floor) {
+				floor = difficulty;
+				gamesOnFloor[std::min(floor, WINNING_FLOOR)] = 1;
+			}
+			PLAYER_ACTION action = bot.chooseAction(simulation); // The bot's thinking is not part of a turn
+			auto start = std::chrono::steady_clock::now();
+			simulation.step(action);
+			simulation.takeEvents(events);
+			tally.turnNanoseconds.add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+			++turnsOnFloor[std::min(floor, WINNING_FLOOR)];
+			++tally.turns;
+		}
+		if (simulation.status != GAME_STATUS::RUNNING) {
+			for (int i = 0; i <= WINNING_FLOOR; ++i) {
+				tally.turnsOnFloor[i] += turnsOnFloor[i];
+				tally.gamesOnFloor[i] += gamesOnFloor[i];
+			}
+		}
+		switch (simulation.status) {
+		case GAME_STATUS::WON:
+			++tally.won;
+			break;
+		case GAME_STATUS::DIED:
+			++tally.died;
+			break;
+		default:
+			++tally.turnLimit;
+			break;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	int games = 1000;
+	int threads = int(std::max(1u, std::thread::hardware_concurrency()));
+	uint64_t seed = 1;
+	int maxTurns = 20000;
+	int width = PLAY_AREA_WIDTH;
+	int height = PLAY_AREA_HEIGHT;
+	const char* output = nullptr;
+	for (int i = 1; i < argc; ++i) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--games") == 0 && hasValue) {
+			games = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+			threads = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+			seed = strtoull(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--max-turns") == 0 && hasValue) {
+			maxTurns = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--width") == 0 && hasValue) {
+			width = std::clamp(atoi(argv[++i]), MIN_MAP_SIZE, MAX_MAP_SIZE);
+		}
+		else if (strcmp(argv[i], "--height") == 0 && hasValue) {
+			height = std::clamp(atoi(argv[++i]), MIN_MAP_SIZE, MAX_MAP_SIZE);
+		}
+		else if (strcmp(argv[i], "--output") == 0 && hasValue) {
+			output = argv[++i];
+		}
+		else {
+			fprintf(stderr, "Usage: %s [--games N] [--threads N] [--seed N] [--max-turns N] [--width N] [--height N] [--output file.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	std::atomic<int> nextGame(0);
+	std::vector<BatchTally> tallies(threads);
+	std::vector<std::thread> workers;
+	auto start = std::chrono::steady_clock::now();
+	for (int worker = 0; worker < threads; ++worker) {
+		workers.emplace_back(playGames, std::ref(nextGame), games, seed, maxTurns, width, height, std::ref(tallies[worker]));
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	BatchTally total;
+	for (auto& tally : tallies) {
+		total.won += tally.won;
+		total.died += tally.died;
+		total.turnLimit += tally.turnLimit;
+		total.turns += tally.turns;
+		for (int floor = 0; floor <= WINNING_FLOOR; ++floor) {
+			total.turnsOnFloor[floor] += tally.turnsOnFloor[floor];
+			total.gamesOnFloor[floor] += tally.gamesOnFloor[floor];
+		}
+		total.turnNanoseconds.merge(tally.turnNanoseconds);
+	}
+	long long p50 = total.turnNanoseconds.percentile(50);
+	long long p99 = total.turnNanoseconds.percentile(99);
+
+	FILE* out = output != nullptr ? fopen(output, "w") : stdout;
+	if (out == nullptr) {
+		fprintf(stderr, "Could not open %s\n", output);
+		return 1;
+	}
+	fprintf(out, "{\n");
+	fprintf(out, "\t\"games\": %d,\n", games);
+	fprintf(out, "\t\"threads\": %d,\n", threads);
+	fprintf(out, "\t\"seed\": %llu,\n", (unsigned long long)seed);
+	fprintf(out, "\t\"width\": %d,\n", width);
+	fprintf(out, "\t\"height\": %d,\n", height);
+	fprintf(out, "\t\"win_rate\": %.4f,\n", double(total.won) / games);
+	fprintf(out, "\t\"death_rate\": %.4f,\n", double(total.died) / games);
+	fprintf(out, "\t\"turn_limit\": %d,\n", total.turnLimit);
+	fprintf(out, "\t\"turns\": %lld,\n", total.turns);
+	fprintf(out, "\t\"turns_per_floor\": [");
+	for (int floor = 1; floor < WINNING_FLOOR; ++floor) {
+		fprintf(out, "%s%.1f", floor > 1 ? ", " : "", total.gamesOnFloor[floor] > 0 ? double(total.turnsOnFloor[floor]) / total.gamesOnFloor[floor] : 0.0);
+	}
+	fprintf(out, "],\n");
+	fprintf(out, "\t\"seconds\": %.3f,\n", seconds);
+	fprintf(out, "\t\"turns_per_second\": %.0f,\n", total.turns / seconds);
+	fprintf(out, "\t\"turn_p50_ns\": %lld,\n", p50);
+	fprintf(out, "\t\"turn_p99_ns\": %lld\n", p99);
+	fprintf(out, "}\n");
+	if (out != stdout) {
+		fclose(out);
+	}
+	return 0;
+}
@@ -0,0 +1,177 @@
+// Headless timings of the hot paths of a turn, written out as JSON so runs can be compared
+// Usage: ConsoleRogueBenchmark [--enemies N] [--iterations N] [--seed N] [--width N] [--height N] [--replay file] [--output file.json]
+#include "GameCore.h"
+#ifdef CONSOLE_ROGUE_RENDER_BENCHMARK
+#include "GameState.h" // Only when libtcod is around - drawing is timed into an offscreen console
+#endif
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+struct BenchmarkResult {
+	std::string name;
+	std::vector<long long> samples; // Nanoseconds per iteration
+};
+
+// Times every call of body separately, so the percentiles mean something
+template <typename Setup, typename Body>
+static BenchmarkResult measure(const std::string& name, const int& iterations, Setup setup, Body body) {
+	BenchmarkResult result{ name, {} };
+	result.samples.reserve(iterations);
+	for (int i = 0; i < iterations; ++i) {
+		setup(i);
+		auto start = std::chrono::steady_clock::now();
+		body(i);
+		auto end = std::chrono::steady_clock::now();
+		result.samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+	}
+	return result;
+}
+
+// Scatters extra goblins over free floor, on top of what the floor spawned on its own
+static void addEnemies(Simulation& simulation, const int& count, const uint64_t& seed) {
+	RandomStream rng(seed, 13);
+	Map& playArea = simulation.playArea;
+	int placed = 0;
+	for (int attempt = 0; placed < count && attempt < count * 100; ++attempt) {
+		int x = rng.getNumber(1, playArea.width - 2);
+		int y = rng.getNumber(1, playArea.height - 2);
+		if (!playArea.isMovementBlocker(x, y)) {
+			playArea.level->spawnEnemy(ACTOR_TYPE::GOBLIN, { x, y });
+			playArea.setTile(x, y, Tileset::goblin);
+			++placed;
+		}
+	}
+	simulation.player->recalculateActiveSight(playArea);
+}
+
+static void writeJson(FILE* out, const std::vector<BenchmarkResult>& results, const uint64_t& seed, const Map& playArea, const int& enemies, const int& iterations) {
+	fprintf(out, "{\n");
+	fprintf(out, "\t\"seed\": %llu,\n", (unsigned long long)seed);
+	fprintf(out, "\t\"width\": %d,\n", playArea.width);
+	fprintf(out, "\t\"height\": %d,\n", playArea.height);
+	// How much of the map ended up stored - it should follow what was generated and seen, not the size
+	fprintf(out, "\t\"tile_chunks\": %d,\n", playArea.tiles.chunksAllocated());
+	fprintf(out, "\t\"sight_chunks\": %d,\n", playArea.visibility.chunksAllocated());
+	fprintf(out, "\t\"map_chunks\": %d,\n", playArea.tiles.chunkCount());
+	fprintf(out, "\t\"enemies\": %d,\n", enemies);
+	fprintf(out, "\t\"iterations\": %d,\n", iterations);
+	fprintf(out, "\t\"results\": [\n");
+	for (size_t i = 0; i < results.size(); ++i) {
+		std::vector<long long> sorted = results[i].samples;
+		std::sort(sorted.begin(), sorted.end());
+		long long total = 0;
+		for (auto& sample : sorted) {
+			total += sample;
+		}
+		fprintf(out, "\t\t{ \"name\": \"%s\", \"mean_ns\": %lld, \"min_ns\": %lld, \"p50_ns\": %lld, \"p99_ns\": %lld }%s\n",
+			results[i].name.c_str(), total / (long long)sorted.size(), sorted.front(), sorted[sorted.size() / 2],
+			sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)], i + 1 < results.size() ? "," : "");
+	}
+	fprintf(out, "\t]\n}\n");
+}
+
+int main(int argc, char* argv[]) {
+	int enemies = 0;
+	int iterations = 1000;
+	uint64_t seed = 1;
+	int width = PLAY_AREA_WIDTH;
+	int height = PLAY_AREA_HEIGHT;
+	const char* output = nullptr;
+	const char* replayPath = nullptr;
+	for (int i = 1; i < argc; ++i) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--enemies") == 0 && hasValue) {
+			enemies = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--iterations") == 0 && hasValue) {
+			iterations = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+			seed = strtoull(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--width") == 0 && hasValue) {
+			width = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--height") == 0 && hasValue) {
+			height = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && hasValue) {
+			replayPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--output") == 0 && hasValue) {
+			output = argv[++i];
+		}
+		else {
+			fprintf(stderr, "Usage: %s [--enemies N] [--iterations N] [--seed N] [--width N] [--height N] [--replay file] [--output file.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	std::vector<BenchmarkResult> results;
+
+	std::vector<Level*> levels;
+	results.push_back(measure("level_generation", iterations, [](const int&) {},
+		[&](const int& i) { levels.push_back(new Level(1, RandomService::deriveSeed(seed, i), std::clamp(width, MIN_MAP_SIZE, MAX_MAP_SIZE), std::clamp(height, MIN_MAP_SIZE, MAX_MAP_SIZE))); }));
+	for (auto& level : levels) {
+		delete level;
+	}
+
+	Simulation simulation(seed, width, height, FLOOR_GENERATION::ON_CALLING_THREAD);
+	Map& playArea = simulation.playArea;
+	Player& player = *simulation.player;
+	addEnemies(simulation, enemies, seed);
+
+	results.push_back(measure("recalculate_active_sight", iterations, [](const int&) {},
+		[&](const int&) { player.recalculateActiveSight(playArea); }));
+
+	results.push_back(measure("reset_active_sight", iterations,
+		[&](const int&) { player.fieldOfView.compute(playArea, player.position[0], player.position[1], player.sightRadius); },
+		[&](const int&) { playArea.resetActiveSight(); }));
+	player.recalculateActiveSight(playArea);
+
+	std::vector<GameEvent> events;
+	results.push_back(measure("update_enemies", iterations,
+		[&](const int&) { player.health = player.maxHealth; events.clear(); },
+		[&](const int&) { playArea.level->updateEnemies(playArea, player, events); }));
+	playArea.drawEnemies();
+	player.recalculateActiveSight(playArea);
+
+	// A whole interaction turn - the attack or pickup, then the enemies' answer and vision
+	results.push_back(measure("player_interract", iterations,
+		[&](const int&) { player.health = player.maxHealth; },
+		[&](const int&) { simulation.step(PLAYER_ACTION::INTERRACT); simulation.takeEvents(events); }));
+
+	// A recorded session is a whole game's worth of turns - a workload that is the same every time
+	if (replayPath != nullptr) {
+		ReplayLog replay;
+		if (!replay.load(replayPath)) {
+			fprintf(stderr, "Not a replay: %s\n", replayPath);
+			return 1;
+		}
+		int runs = std::max(1, iterations / 100);
+		results.push_back(measure("replay", runs, [](const int&) {},
+			[&](const int&) { Simulation replayed(replay.seed, replay.width, replay.height, FLOOR_GENERATION::ON_CALLING_THREAD); replay.play(replayed); }));
+	}
+
+#ifdef CONSOLE_ROGUE_RENDER_BENCHMARK
+	tcod::Console console{ CONSOLE_WIDTH, CONSOLE_HEIGHT };
+	PlayAreaSection playAreaSection(std::make_shared<Palette>());
+	results.push_back(measure("draw_whole_map", iterations, [](const int&) {},
+		[&](const int&) { playAreaSection.drawWholeMap(console, playArea, player); }));
+#endif
+
+	FILE* out = output != nullptr ? fopen(output, "w") : stdout;
+	if (out == nullptr) {
+		fprintf(stderr, "Could not open %s\n", output);
+		return 1;
+	}
+	writeJson(out, results, seed, playArea, enemies, iterations);
+	if (out != stdout) {
+		fclose(out);
+	}
+	return 0;
+}
@@ -0,0 +1,67 @@
+#include "GameCore.h"
+
+DistanceMap::DistanceMap() : goalX(-1), goalY(-1), terrainVersion(0), computed(false) {}
+
+void DistanceMap::update(const Map& playArea, const int& goalX, const int& goalY) {
+	if (this->computed && goalX == this->goalX && goalY == this->goalY && playArea.terrainVersion == this->terrainVersion) {
+		return; // Nothing the distances depend on has changed
+	}
+	this->goalX = goalX;
+	this->goalY = goalY;
+	this->terrainVersion = playArea.terrainVersion;
+	this->recompute(playArea);
+	this->computed = true;
+}
+
+void DistanceMap::recompute(const Map& playArea) {
+	this->window = MapWindow(playArea.width, playArea.height, this->goalX, this->goalY, reach);
+	int stride = this->window.width + 2;
+	// The terrain is read once up front - the search itself then only ever looks at this array
+	this->distances.assign(stride * (this->window.height + 2), blocked);
+	for (int y = this->window.top; y < this->window.top + this->window.height; ++y) {
+		for (int x = this->window.left; x < this->window.left + this->window.width; ++x) {
+			if (!playArea.isTerrainBlocker(x, y)) {
+				this->distances[paddedIndexOf(x, y)] = unreachable;
+			}
+		}
+	}
+	this->frontier.resize(this->window.size());
+	// Every step costs the same, so the bucket queue only ever has the current and the next bucket open -
+	// one FIFO holds both, and every cell goes through it once
+	int head = 0;
+	int tail = 0;
+	this->distances[paddedIndexOf(this->goalX, this->goalY)] = 0;
+	this->frontier[tail++] = paddedIndexOf(this->goalX, this->goalY);
+	const int steps[4] = { 1, -1, stride, -stride }; // Same order as everywhere else - right, left, down, up
+	while (head < tail) {
+		int cell = this->frontier[head++];
+		for (int direction = 0; direction < 4; ++direction) {
+			int next = cell + steps[direction];
+			if (this->distances[next] == unreachable) { // Neither blocked nor reached yet
+				this->distances[next] = this->distances[cell] + 1;
+				this->frontier[tail++] = next;
+			}
+		}
+	}
+}
+
+bool DistanceMap::stepDownhill(const Map& playArea, const int& x, const int& y, int& xChange, int& yChange) const {
+	const int xChanges[4] = { 1, -1, 0, 0 };
+	const int yChanges[4] = { 0, 0, 1, -1 };
+	int best = distanceAt(x, y);
+	bool found = false;
+	for (int direction = 0; direction < 4; ++direction) {
+		int nextX = x + xChanges[direction];
+		int nextY = y + yChanges[direction];
+		if (playArea.isMovementBlocker(nextX, nextY)) { // Someone else may be standing there right now
+			continue;
+		}
+		if (distanceAt(nextX, nextY) < best) {
+			best = distanceAt(nextX, nextY);
+			xChange = xChanges[direction];
+			yChange = yChanges[direction];
+			found = true;
+		}
+	}
+	return found;
+}
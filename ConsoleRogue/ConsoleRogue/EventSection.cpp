@@ -1,23 +1,45 @@
 #include "GameState.h"
 #include "libtcod.hpp"
 #include "SDL.h"
-#include <string>
-#include <deque>
+#include <cstdio>
 
-void EventSection::colorArea(tcod::Console& console, tcod::ContextPtr& context) {
-	tcod::draw_rect(console, { 0, PLAY_AREA_HEIGHT, EVENT_AREA_WIDTH, EVENT_AREA_HEIGHT }, ' ', std::nullopt, this->palette->eventBackground);
-	context->present(console);
+void EventSection::newEvent(const LOG_MESSAGE& message, const int& argument) {
+	this->events.add({ message, argument }); // Sometimes, enemies may create more then 1 event per player action - only the last few are kept
 }
 
-void EventSection::newEvent(tcod::Console& console, tcod::ContextPtr& context, std::string eventDescription) {
-	this->events.push_back(eventDescription);
-	while (this->events.size() > 5) { this->events.pop_front(); } // Sometimes, enemies may create more then 1 event per player action
-	this->drawEvents(console, context);
+void EventSection::restoreEvents(const EventLog& events) {
+	this->events = events;
 }
 
-void EventSection::drawEvents(tcod::Console& console, tcod::ContextPtr& context) {
-	colorArea(console, context);
+void EventSection::draw(tcod::Console& console, const bool& force) {
+	bool changed = !this->panelDrawn || this->events != this->shownEvents;
+	if (changed) {
+		this->shownEvents = this->events;
+		this->drawPanel();
+		this->panelDrawn = true;
+	}
+	if (changed || force) {
+		tcod::blit(console, this->panel, { 0, PLAY_AREA_HEIGHT });
+	}
+}
+
+// Indexed by LOG_MESSAGE
+static const char* messageTemplates[int(LOG_MESSAGE::_count)] = {
+	"You moved north",
+	"You moved south",
+	"You moved west",
+	"You moved east",
+	"You damaged a goblin for %d damage!",
+	"You killed a goblin",
+	"A goblin damaged you for %d",
+	"You entered a new floor",
+};
+
+void EventSection::drawPanel() {
+	tcod::draw_rect(this->panel, { 0, 0, EVENT_AREA_WIDTH, EVENT_AREA_HEIGHT }, ' ', std::nullopt, this->palette->eventBackground);
+	char line[EVENT_AREA_WIDTH];
 	for (int i = 0; i < this->events.size(); ++i) {
-		tcod::print(console, { 1, PLAY_AREA_HEIGHT + 2 + (i*2) }, this->events[i], this->palette->eventHeaders, this->palette->eventBackground);
+		snprintf(line, sizeof(line), messageTemplates[int(this->events[i].message)], this->events[i].argument); // Templates without a number just ignore it
+		tcod::print(this->panel, { 1, 2 + (i*2) }, line, this->palette->eventHeaders, this->palette->eventBackground);
 	}
-}
\ No newline at end of file
+}
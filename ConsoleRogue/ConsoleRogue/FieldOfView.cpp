@@ -0,0 +1,83 @@
+#include "GameCore.h"
+#include <vector>
+
+typedef FieldOfView::Slope Slope;
+typedef FieldOfView::Row Row;
+
+static int floorDivide(const int& numerator, const int& denominator) {
+	int quotient = numerator / denominator;
+	if ((numerator % denominator != 0) && ((numerator < 0) != (denominator < 0))) {
+		--quotient;
+	}
+	return quotient;
+}
+
+// depth * slope, rounded to the nearest column with ties going up
+static int roundTiesUp(const int& depth, const Slope& slope) {
+	return floorDivide(2 * depth * slope.numerator + slope.denominator, 2 * slope.denominator);
+}
+
+// depth * slope, rounded to the nearest column with ties going down
+static int roundTiesDown(const int& depth, const Slope& slope) {
+	return -floorDivide(-(2 * depth * slope.numerator - slope.denominator), 2 * slope.denominator);
+}
+
+// The slope to the near edge of a tile
+static Slope slopeOf(const int& depth, const int& column) {
+	return { 2 * column - 1, 2 * depth };
+}
+
+// A floor tile is only lit when its center lies within the row - this is what makes the result symmetric
+static bool isSymmetric(const Row& row, const int& column) {
+	return column * row.start.denominator >= row.depth * row.start.numerator &&
+		column * row.end.denominator <= row.depth * row.end.numerator;
+}
+
+// Quadrant 0 looks north, 1 east, 2 south, 3 west
+static void toMap(const int& quadrant, const int& originX, const int& originY, const int& depth, const int& column, int& x, int& y) {
+	switch (quadrant) {
+	case 0: x = originX + column; y = originY - depth; break;
+	case 1: x = originX + depth; y = originY + column; break;
+	case 2: x = originX + column; y = originY + depth; break;
+	default: x = originX - depth; y = originY + column; break;
+	}
+}
+
+void FieldOfView::compute(Map& playArea, const int& originX, const int& originY, const int& radius) {
+	playArea.setVisible(originX, originY);
+	int radiusSquared = radius * radius + radius; // The extra radius rounds the circle out, so it isn't spiky at the axes
+	std::vector<Row>& rows = this->rows;
+	rows.clear(); // Keeps its capacity from the last call
+	for (int quadrant = 0; quadrant < 4; ++quadrant) {
+		rows.push_back({ 1, { -1, 1 }, { 1, 1 } });
+		while (!rows.empty()) {
+			Row row = rows.back();
+			rows.pop_back();
+			if (row.depth > radius) {
+				continue;
+			}
+			int minColumn = roundTiesUp(row.depth, row.start);
+			int maxColumn = roundTiesDown(row.depth, row.end);
+			int previous = -1; // -1 nothing scanned yet, 0 floor, 1 wall
+			for (int column = minColumn; column <= maxColumn; ++column) {
+				int x, y;
+				toMap(quadrant, originX, originY, row.depth, column, x, y);
+				bool isWall = playArea.isSightBlocker(x, y);
+				if ((isWall || isSymmetric(row, column)) && row.depth * row.depth + column * column <= radiusSquared &&
+					playArea.isOnMap(x, y)) {
+					playArea.setVisible(x, y);
+				}
+				if (previous == 1 && !isWall) { // Coming out of a shadow
+					row.start = slopeOf(row.depth, column);
+				}
+				if (previous == 0 && isWall) { // Going into a shadow - everything before it continues in the next row
+					rows.push_back({ row.depth + 1, row.start, slopeOf(row.depth, column) });
+				}
+				previous = isWall ? 1 : 0;
+			}
+			if (previous == 0) {
+				rows.push_back({ row.depth + 1, row.start, row.end });
+			}
+		}
+	}
+}
@@ -1,6 +1,11 @@
 #include "GameState.h"
+#include <string>
+#include <cstdio>
 
-Game::Game(const std::shared_ptr<Palette> palette) : palette(palette), player(new Player()), playArea(palette), statSection(palette), eventSection(palette) {
+Game::Game(const std::shared_ptr<Palette> palette, const uint64_t& seed, const int& width, const int& height) : palette(palette), simulation(seed, width, height), playAreaSection(palette), statSection(palette), eventSection(palette),
+	frameChanged(true), presentsThisTurn(0), presentsLastTurn(0), showProfilerOverlay(false), replay(seed, width, height), floorSaved(1) {
+
+	simulation.profiler = &profiler;
 
 	console = tcod::Console{ CONSOLE_WIDTH, CONSOLE_HEIGHT };  // Main console.
 
@@ -14,134 +19,149 @@ Game::Game(const std::shared_ptr<Palette> palette) : palette(palette), player(ne
 	context = tcod::new_context(params);
 
 	// Initialise and sketch out Stat section of console
-	statSection.setPlayer(player);
-	statSection.colorArea(console, context);
-	statSection.drawTextFields(console, context);
-	statSection.drawStatValues(console, context);
-
-	//Initialise play area
-	playArea.setupNewPlayArea(*player, console, context);
+	statSection.setPlayer(simulation.player);
+	statSection.draw(console, true);
 
-	// Instantiate player vision
-	// This does not cause the bug to manifest
-	player->recalculateActiveSight(playArea);
-	playArea.drawWholeMap(console, context);
+	// The simulation has already set up the play area and player vision
+	playAreaSection.drawWholeMap(console, simulation.playArea, *simulation.player);
 
 	// Initialise eventArea
-	eventSection.colorArea(console, context);
+	eventSection.draw(console, true);
+	presentFrame();
 }
 
-void Game::playerMove(DIRECTIONS direction) {
-	switch (direction) {
-	case DIRECTIONS::MOVE_DOWN:
-		this->player->placeSelf(this->playArea, this->player->position[0], this->player->position[1] + 1);
-		this->eventSection.newEvent(console, context, "You moved south");
-		break;
-	case DIRECTIONS::MOVE_UP:
-		this->player->placeSelf(this->playArea, this->player->position[0], this->player->position[1] - 1);
-		this->eventSection.newEvent(console, context, "You moved north");
-		break;
-	case DIRECTIONS::MOVE_LEFT:
-		this->player->placeSelf(this->playArea, this->player->position[0] - 1, this->player->position[1]);
-		this->eventSection.newEvent(console, context, "You moved west");
-		break;
-	case DIRECTIONS::MOVE_RIGHT:
-		this->player->placeSelf(this->playArea, this->player->position[0] + 1, this->player->position[1]);
-		this->eventSection.newEvent(console, context, "You moved east");
-		break;
+void Game::playerAction(PLAYER_ACTION action) {
+	if (this->simulation.status != GAME_STATUS::RUNNING) {
+		return; // Leave the final screen alone
+	}
+	this->presentsLastTurn = this->presentsThisTurn;
+	this->presentsThisTurn = 0;
+	this->replay.record(action);
+	this->simulation.step(action);
+	{
+		ProfileScope drawing(&this->profiler, TURN_PHASE::DRAWING);
+		this->drawTurn();
+	}
+	this->frameChanged = true;
+	if (this->simulation.status != GAME_STATUS::RUNNING) {
+		std::remove(AUTOSAVE_FILE); // The run is over, there is nothing to continue
 	}
+	else if (this->simulation.playArea.level->difficultyLevel != this->floorSaved) {
+		this->saveGame(AUTOSAVE_FILE);
+		this->floorSaved = this->simulation.playArea.level->difficultyLevel;
+	}
+}
 
-	if (this->playArea.level->difficultyLevel < 3) {
-		this->player->recalculateActiveSight(this->playArea);
-		this->playArea.level->updateEnemies(this->playArea, this->player, this->eventSection, console, context);
-		if (this->player->health < 1) {
-			this->playArea.level->difficultyLevel = 3;
-			TCOD_console_clear(console.get());
-			tcod::print(console, { PLAY_AREA_WIDTH / 2, PLAY_AREA_HEIGHT / 2 }, "You died!", this->palette->statHeaders, std::nullopt);
-			context->present(console);
-			return;
-		}
-		this->statSection.drawStatValues(this->console, this->context);
-		this->player->recalculateActiveSight(this->playArea);
-		this->playArea.drawWholeMap(this->console, this->context);
+void Game::presentFrame() {
+	if (!this->frameChanged) {
+		return;
 	}
+	if (this->showProfilerOverlay && this->simulation.status == GAME_STATUS::RUNNING) {
+		this->statSection.drawProfilerOverlay(this->console, this->profiler, this->presentsLastTurn, *this->simulation.playArea.level);
+	}
+	{
+		ProfileScope present(&this->profiler, TURN_PHASE::PRESENT);
+		context->present(console); // With vsync on, this is the only call in a turn allowed to block
+	}
+	++this->presentsThisTurn;
+	this->frameChanged = false;
+	this->profiler.finishFrame();
 }
 
-void Game::playerInterract() {
-	bool interractionOccured = false;
-	if (!interractionOccured) {
-		for (int i = 0; i < this->playArea.level->hostileActors.size(); ++i) { // We will be erasing elements from vector by position, so we need the index
-			if ((abs(this->playArea.level->hostileActors[i]->position[0] - this->player->position[0]) <= this->player->range) &&
-				(abs(this->playArea.level->hostileActors[i]->position[1] - this->player->position[1]) <= this->player->range) &&
-				(this->playArea.visited[this->playArea.level->hostileActors[i]->position[0]][this->playArea.level->hostileActors[i]->position[1]] == 2)) { // Enemy is both within range and in line of sight
-				this->playArea.level->hostileActors[i]->health -= (*player).damage - (this->playArea.level->hostileActors[i]->armor/2);
-				this->eventSection.newEvent(console, context, "You damaged a goblin for " + std::to_string((*player).damage - (this->playArea.level->hostileActors[i]->armor / 2)) + " damage!");
-				interractionOccured = true;
-				if (this->playArea.level->hostileActors[i]->health < 1) { // Actor was killed
-					this->playArea.tiles[this->playArea.level->hostileActors[i]->position[0]][this->playArea.level->hostileActors[i]->position[1]] = Tileset::floor;
-					this->playArea.level->hostileActors.erase(this->playArea.level->hostileActors.begin() + i);
-					this->eventSection.newEvent(console, context, "You killed a goblin");
-				}
-				break; // Only one interraction per action premitted
-			}
-		}
+void Game::endSession() {
+	if (this->simulation.status == GAME_STATUS::RUNNING) {
+		this->saveGame(AUTOSAVE_FILE);
 	}
-	
-	if (!interractionOccured) {
-		// No enemies in sight were found, check for pickups
-		for (int i = 0; i < this->playArea.level->pickups.size(); ++i) { // We will be erasing elements from vector by position, so we need the index
-			if ((abs(this->playArea.level->pickups[i]->position[0] - this->player->position[0]) <= this->player->range) &&
-				(abs(this->playArea.level->pickups[i]->position[1] - this->player->position[1]) <= this->player->range) &&
-				(this->playArea.visited[this->playArea.level->pickups[i]->position[0]][this->playArea.level->pickups[i]->position[1]] == 2)) { // Pickup is both within range and in line of sight
-				interractionOccured = true;
-				this->player->playerInterract(*this->playArea.level->pickups[i]);
-				this->playArea.tiles[this->playArea.level->pickups[i]->position[0]][this->playArea.level->pickups[i]->position[1]] = Tileset::floor;
-				if (this->playArea.level->pickups[i]->type == PICKUP_TYPE::EXIT) { // Player found and entered the exit
-
-					this->setupNewFloor();
-					this->eventSection.newEvent(console, context, "You entered a new floor");
-					if (this->playArea.level->difficultyLevel < 3) {
-						TCOD_console_clear(console.get());
-						tcod::print(console, { PLAY_AREA_WIDTH/2, PLAY_AREA_HEIGHT/2 }, "You won!", this->palette->statHeaders, std::nullopt);
-						context->present(console);
-					}
-					return;
-				}
-				this->playArea.level->pickups.erase(this->playArea.level->pickups.begin()+i); // Pickups are one-time use only
-				break; // Only one interraction per action premitted
-			}
-		}
+	this->replay.finishRecording(this->simulation.stateHash());
+}
+
+bool Game::saveGame(const std::string& path) {
+	return SaveGame::write(path, this->simulation.snapshot(), this->eventSection.getEvents(), this->replay.actions);
+}
+
+bool Game::loadGame(const std::string& path) {
+	GameSnapshot snapshot;
+	EventLog eventLog;
+	std::vector<PLAYER_ACTION> actions;
+	if (!SaveGame::read(path, snapshot, eventLog, actions) || snapshot.status != GAME_STATUS::RUNNING) {
+		return false;
 	}
-	if (this->playArea.level->difficultyLevel < 3) {
-		this->statSection.drawStatValues(this->console, this->context);
-		this->playArea.level->updateEnemies(this->playArea, this->player, this->eventSection, console, context);
-		if (this->player->health < 1) {
-			this->playArea.level->difficultyLevel = 3;
-			TCOD_console_clear(console.get());
-			tcod::print(console, { PLAY_AREA_WIDTH / 2, PLAY_AREA_HEIGHT / 2 }, "You died!", this->palette->statHeaders, std::nullopt);
-			context->present(console);
-			return;
-		}
-		this->statSection.drawStatValues(this->console, this->context);
-		this->player->recalculateActiveSight(this->playArea);
-		this->playArea.drawWholeMap(this->console, this->context);
+	this->simulation.restore(snapshot);
+	// The recording carries on from the saved actions, so a replay still starts from the run seed
+	this->replay.seed = snapshot.runSeed;
+	this->replay.width = snapshot.width;
+	this->replay.height = snapshot.height;
+	this->replay.actions = actions;
+	this->floorSaved = snapshot.difficultyLevel;
+	this->drawNewFloor();
+	this->eventSection.restoreEvents(eventLog);
+	this->eventSection.draw(this->console);
+	this->frameChanged = true;
+	return true;
+}
+
+void Game::toggleProfilerOverlay() {
+	this->showProfilerOverlay = !this->showProfilerOverlay;
+	if (!this->showProfilerOverlay && this->simulation.status == GAME_STATUS::RUNNING) { // Paint the stat section over it again
+		this->statSection.draw(this->console, true);
 	}
+	this->frameChanged = true;
 }
 
-void Game::setupNewFloor() {
+void Game::drawNewFloor() {
 	TCOD_console_clear(console.get());
 
-	statSection.colorArea(console, context);
-	statSection.drawTextFields(console, context);
-	statSection.drawStatValues(console, context);
+	// Both panels only lost their place on the main console, what they show is still drawn on their own
+	statSection.draw(console, true);
+	eventSection.draw(console, true);
 
-	eventSection.colorArea(console, context);
+	playAreaSection.drawWholeMap(console, simulation.playArea, *simulation.player);
+}
 
-	playArea.generateNewLevel(this->playArea.level->difficultyLevel+1);
-	playArea.setupNewPlayArea(*player, console, context);
+void Game::drawTurn() {
+	this->simulation.takeEvents(this->turnEvents);
+	for (auto& event : this->turnEvents) {
+		switch (event.type) {
+		case GAME_EVENT_TYPE::PLAYER_MOVED:
+			switch (DIRECTIONS(event.value)) {
+			case DIRECTIONS::MOVE_DOWN:
+				this->eventSection.newEvent(LOG_MESSAGE::MOVED_SOUTH);
+				break;
+			case DIRECTIONS::MOVE_UP:
+				this->eventSection.newEvent(LOG_MESSAGE::MOVED_NORTH);
+				break;
+			case DIRECTIONS::MOVE_LEFT:
+				this->eventSection.newEvent(LOG_MESSAGE::MOVED_WEST);
+				break;
+			case DIRECTIONS::MOVE_RIGHT:
+				this->eventSection.newEvent(LOG_MESSAGE::MOVED_EAST);
+				break;
+			}
+			break;
+		case GAME_EVENT_TYPE::ENEMY_DAMAGED:
+			this->eventSection.newEvent(LOG_MESSAGE::DAMAGED_GOBLIN, event.value);
+			break;
+		case GAME_EVENT_TYPE::ENEMY_KILLED:
+			this->eventSection.newEvent(LOG_MESSAGE::KILLED_GOBLIN);
+			break;
+		case GAME_EVENT_TYPE::PLAYER_DAMAGED:
+			this->eventSection.newEvent(LOG_MESSAGE::DAMAGED_BY_GOBLIN, event.value);
+			break;
+		case GAME_EVENT_TYPE::FLOOR_ENTERED:
+			this->drawNewFloor();
+			this->eventSection.newEvent(LOG_MESSAGE::ENTERED_FLOOR);
+			break;
+		default: // Pickups speak for themselves in the stat section, the end of the run is handled below
+			break;
+		}
+	}
 
-	// Instantiate player vision
-	// This does not cause the bug to manifest
-	player->recalculateActiveSight(playArea);
-	playArea.drawWholeMap(console, context);
-}
\ No newline at end of file
+	if (this->simulation.status != GAME_STATUS::RUNNING) {
+		TCOD_console_clear(console.get());
+		tcod::print(console, { PLAY_AREA_WIDTH / 2, PLAY_AREA_HEIGHT / 2 }, this->simulation.status == GAME_STATUS::WON ? "You won!" : "You died!", this->palette->statHeaders, std::nullopt);
+		return;
+	}
+	this->statSection.draw(this->console);
+	this->eventSection.draw(this->console);
+	this->playAreaSection.drawChangedTiles(this->console, this->simulation.playArea, *this->simulation.player);
+}
@@ -0,0 +1,983 @@
+#ifndef GAME_CORE_H
+#define GAME_CORE_H
+
+// Everything in this header is pure game logic - no libtcod, no SDL
+// It is built on its own as the ConsoleRogueCore library, so turns can be simulated without a window
+
+// The size of a map unless asked for another, and of the part of the screen showing it
+#define PLAY_AREA_HEIGHT 60
+#define PLAY_AREA_WIDTH 80
+
+// Limits for either side of a map chosen at runtime
+#define MIN_MAP_SIZE 48 // Any smaller and rooms can run out of places that keep clear of the safe and exit rooms
+#define MAX_MAP_SIZE 4096
+#define MAP_CHUNK_SIZE 32 // Maps are stored in square chunks this many cells across, allocated only once used
+
+#define WINNING_FLOOR 3 // Reaching this floor ends the run
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <memory_resource>
+#include <future>
+#include <chrono>
+#include <fstream>
+
+enum class DIRECTIONS {
+	MOVE_UP,
+	MOVE_DOWN,
+	MOVE_LEFT,
+	MOVE_RIGHT,
+};
+
+// Everything the player can do in a single turn
+enum class PLAYER_ACTION {
+	MOVE_UP,
+	MOVE_DOWN,
+	MOVE_LEFT,
+	MOVE_RIGHT,
+	INTERRACT,
+};
+
+enum class GAME_STATUS {
+	RUNNING,
+	WON,
+	DIED,
+};
+
+// What happened during a turn - front-ends decide how (and if) to show it
+enum class GAME_EVENT_TYPE {
+	PLAYER_MOVED, // value: DIRECTIONS
+	ENEMY_DAMAGED, // value: damage dealt
+	ENEMY_KILLED, // value: ACTOR_TYPE
+	PLAYER_DAMAGED, // value: damage taken
+	PICKUP_COLLECTED, // value: PICKUP_TYPE
+	FLOOR_ENTERED, // value: new difficulty level
+	PLAYER_WON,
+	PLAYER_DIED,
+};
+
+struct GameEvent {
+	GAME_EVENT_TYPE type;
+	int value;
+};
+
+enum class ROOM_TYPE {
+	CORRIDOR,
+	CAVE,
+	ROOM,
+	BLOCKER,
+	DISJOINT,
+	SAFE_ROOM,
+};
+
+// Not treating exit as a pickup would introduce pointless extra complexity. It behaves like one, we just don't randomly generate more
+enum class PICKUP_TYPE {
+	EXIT = 0,
+	DAMAGE = 1,
+	ARMOR = 2,
+	SPEED = 3,
+	HEALTH_REFILL = 4,
+	HEALTH_UPGRADE = 5,
+	RANGE = 6,
+	_count = 7,
+};
+
+enum class ACTOR_TYPE {
+	GOBLIN = 0,
+	UNDETERMINED = 1,
+	_count = 2,
+};
+
+// Where the time of a turn goes - see TurnProfiler
+enum class TURN_PHASE {
+	INPUT = 0,
+	MOVEMENT = 1, // The player's own action - moving, attacking, picking up
+	ENEMIES = 2,
+	FIELD_OF_VIEW = 3,
+	DRAWING = 4,
+	PRESENT = 5,
+	_count = 6,
+};
+
+// Every subsystem draws from its own stream, so adding a roll in one doesn't reshuffle the others
+enum class RNG_STREAM {
+	ROOM_PLACEMENT = 0,
+	PICKUPS = 1,
+	ENEMIES = 2,
+	COMBAT = 3,
+	_count = 4,
+};
+
+// Where the next floor is built. The front end wants it ready before the exit is found, headless runs want no threads of their own
+enum class FLOOR_GENERATION {
+	PREFETCHED, // On a worker thread, while the current floor is played
+	ON_CALLING_THREAD, // Only once the exit is taken
+};
+
+// PCG32 - 16 bytes of state instead of the 5KB of mt19937, and cheap enough to call in tight generation loops
+class RandomStream {
+public:
+	RandomStream(uint64_t seed = 0, uint64_t streamId = 0);
+	uint32_t next();
+	// Inclusive on both ends. Unlike std::uniform_int_distribution, the result is the same on every compiler
+	int getNumber(const int& from, const int& to);
+private:
+	uint64_t state;
+	uint64_t increment;
+};
+
+// One seed per run - everything else is derived from it, so a floor can be regenerated from its seed alone
+class RandomService {
+public:
+	RandomService(uint64_t seed = 0);
+	RandomStream& get(RNG_STREAM stream) { return streams[int(stream)]; }
+	uint64_t getSeed() const { return seed; }
+	static uint64_t deriveSeed(const uint64_t& seed, const uint64_t& key);
+	static uint64_t seedFromEntropy(); // The only place the OS entropy source is touched
+private:
+	uint64_t seed;
+	std::array<RandomStream, int(RNG_STREAM::_count)> streams;
+};
+
+// Simply store all used characters here for easy global changes
+class Tileset {
+public:
+	static constexpr char wall = '#';
+	static constexpr char goblin = 'G';
+	static constexpr char player = '@';
+	static constexpr char floor = '.';
+	static constexpr char exit = 'E';
+	static constexpr char damagePickup = 'D';
+	static constexpr char speedPickup = 'S';
+	static constexpr char armorPickup = 'A';
+	static constexpr char healthRefillPickup = 'H';
+	static constexpr char healthUpgradePickup = 'M';
+	static constexpr char rangePickup = 'R';
+private:
+	// This class only holds static data
+	// Forbid creating its instances
+	Tileset() {}
+};
+
+// Everything the game needs to know about a glyph, so tile queries are a single table lookup
+class TileProperties {
+public:
+	static constexpr uint16_t blocksSight = 1 << 0;
+	static constexpr uint16_t blocksMovement = 1 << 1;
+	static constexpr uint16_t isPickup = 1 << 2;
+	static constexpr uint16_t isActor = 1 << 3;
+	static constexpr int pickupTypeShift = 8; // The PICKUP_TYPE of a pickup glyph is kept in the high byte
+
+	static constexpr uint16_t of(const char& tile) { return table[(unsigned char)tile]; }
+	static constexpr bool has(const char& tile, const uint16_t& flags) { return (of(tile) & flags) != 0; }
+	static constexpr PICKUP_TYPE pickupType(const char& tile) { return PICKUP_TYPE(of(tile) >> pickupTypeShift); }
+private:
+	TileProperties() {} // Static data only, same as Tileset
+
+	static constexpr uint16_t pickup(const PICKUP_TYPE& type) {
+		return blocksSight | blocksMovement | isPickup | uint16_t(int(type) << pickupTypeShift);
+	}
+	static constexpr std::array<uint16_t, 256> build() {
+		std::array<uint16_t, 256> properties{}; // Unknown glyphs behave like floor
+		properties[(unsigned char)Tileset::wall] = blocksSight | blocksMovement;
+		properties[(unsigned char)Tileset::goblin] = blocksSight | blocksMovement | isActor;
+		properties[(unsigned char)Tileset::player] = blocksMovement | isActor;
+		properties[(unsigned char)Tileset::exit] = pickup(PICKUP_TYPE::EXIT);
+		properties[(unsigned char)Tileset::damagePickup] = pickup(PICKUP_TYPE::DAMAGE);
+		properties[(unsigned char)Tileset::speedPickup] = pickup(PICKUP_TYPE::SPEED);
+		properties[(unsigned char)Tileset::armorPickup] = pickup(PICKUP_TYPE::ARMOR);
+		properties[(unsigned char)Tileset::healthRefillPickup] = pickup(PICKUP_TYPE::HEALTH_REFILL);
+		properties[(unsigned char)Tileset::healthUpgradePickup] = pickup(PICKUP_TYPE::HEALTH_UPGRADE);
+		properties[(unsigned char)Tileset::rangePickup] = pickup(PICKUP_TYPE::RANGE);
+		return properties;
+	}
+	static const std::array<uint16_t, 256> table;
+};
+
+inline constexpr std::array<uint16_t, 256> TileProperties::table = TileProperties::build();
+
+class Pickup {
+public:
+	Pickup(PICKUP_TYPE type, std::array<int, 2> position) : type(type), position(position) {}
+	PICKUP_TYPE type;
+	std::array<int, 2> position;
+};
+
+// Bump allocator for everything a single floor creates - rooms, pickups, actors and the vectors holding them
+// Nothing is freed on its own; the whole floor is released at once when its Level is destroyed
+class LevelArena : public std::pmr::memory_resource {
+public:
+	LevelArena(const size_t& blockSize = 16 * 1024);
+	~LevelArena();
+	LevelArena(const LevelArena&) = delete;
+	LevelArena& operator=(const LevelArena&) = delete;
+	// Objects made here never have their destructors run, so they may only own memory that also comes from the arena
+	template <typename T, typename... Args>
+	T* create(Args&&... args) {
+		return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+	size_t bytesUsed() const { return used; } // What was actually handed out
+	size_t bytesReserved() const { return reserved; } // Including the unused tails of blocks
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void*, size_t, size_t) override {} // Reclaimed with the whole arena
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	size_t blockSize;
+	std::vector<char*> blocks;
+	char* current;
+	size_t remaining;
+	size_t used;
+	size_t reserved;
+};
+
+// A width x height area cut into MAP_CHUNK_SIZE square chunks, each allocated the first time something is written into it
+// Until then a chunk is the shared empty one, so reads never have to check - it is never written to
+template <typename Chunk>
+class ChunkTable {
+public:
+	static constexpr int chunkSize = MAP_CHUNK_SIZE;
+	static constexpr int chunkShift = 5; // Cells are only ever looked up on the map, so shifts and masks are safe
+	static_assert(1 << chunkShift == chunkSize, "MAP_CHUNK_SIZE has to be a power of two, and chunkShift its log");
+
+	ChunkTable(const Chunk& empty = Chunk()) : columns(0), rows(0), empty(empty) {}
+	ChunkTable(const ChunkTable&) = delete; // Every slot may point at our own empty chunk
+	ChunkTable& operator=(const ChunkTable&) = delete;
+	// Drops every chunk
+	void reset(const int& width, const int& height) {
+		this->columns = (width + chunkSize - 1) / chunkSize;
+		this->rows = (height + chunkSize - 1) / chunkSize;
+		this->slots.assign(this->columns * this->rows, &this->empty);
+		this->owned.clear();
+		this->allocated.clear();
+	}
+	int indexOf(const int& x, const int& y) const { return (y >> chunkShift) * this->columns + (x >> chunkShift); }
+	int leftOf(const int& index) const { return (index % this->columns) * chunkSize; }
+	int topOf(const int& index) const { return (index / this->columns) * chunkSize; }
+	int chunkCount() const { return this->columns * this->rows; }
+	const Chunk& find(const int& x, const int& y) const { return *this->slots[indexOf(x, y)]; }
+	const Chunk& chunkAt(const int& index) const { return *this->slots[index]; }
+	bool isAllocated(const int& index) const { return this->slots[index] != &this->empty; }
+	// New chunks start as copies of the empty one
+	Chunk& allocate(const int& index) {
+		if (!isAllocated(index)) {
+			this->owned.push_back(std::make_unique<Chunk>(this->empty));
+			this->slots[index] = this->owned.back().get();
+			this->allocated.push_back(index);
+		}
+		return *this->slots[index];
+	}
+	Chunk& at(const int& x, const int& y) { return allocate(indexOf(x, y)); }
+	const std::vector<int>& allocatedChunks() const { return this->allocated; } // In the order they were first written to
+private:
+	int columns;
+	int rows;
+	Chunk empty;
+	std::vector<Chunk*> slots; // Row major
+	std::vector<std::unique_ptr<Chunk>> owned;
+	std::vector<int> allocated;
+};
+
+// One value per cell, stored in chunks. Cells nobody wrote to hold the empty value and take no memory
+template <typename T>
+class ChunkedGrid {
+public:
+	static constexpr int chunkSize = MAP_CHUNK_SIZE;
+	typedef std::array<T, chunkSize * chunkSize> Chunk; // Row major
+
+	ChunkedGrid(const T& empty) : empty(empty), chunks(filledWith(empty)) {}
+	void reset(const int& width, const int& height) { this->chunks.reset(width, height); } // Every cell goes back to empty
+	const T& get(const int& x, const int& y) const { return this->chunks.find(x, y)[offsetOf(x, y)]; }
+	void set(const int& x, const int& y, const T& value) {
+		if (value == this->empty && !this->chunks.isAllocated(this->chunks.indexOf(x, y))) {
+			return; // Nothing to store
+		}
+		at(x, y) = value;
+	}
+	// Allocates the cell's chunk if need be - for reading and writing the same cell with a single lookup
+	T& at(const int& x, const int& y) { return this->chunks.at(x, y)[offsetOf(x, y)]; }
+	int chunkCount() const { return this->chunks.chunkCount(); }
+	int chunksAllocated() const { return int(this->chunks.allocatedChunks().size()); }
+	// Every allocated chunk as its index, and its cells one chunk after another
+	void exportChunks(std::vector<int>& indices, std::vector<T>& cells) const {
+		indices = this->chunks.allocatedChunks();
+		cells.clear();
+		for (auto& index : indices) {
+			const Chunk& chunk = this->chunks.chunkAt(index);
+			cells.insert(cells.end(), chunk.begin(), chunk.end());
+		}
+	}
+	// The other way round - indices have to be below chunkCount(), with a whole chunk of cells for each
+	void importChunks(const std::vector<int>& indices, const std::vector<T>& cells) {
+		for (size_t i = 0; i < indices.size(); ++i) {
+			Chunk& chunk = this->chunks.allocate(indices[i]);
+			std::copy(cells.begin() + i * chunk.size(), cells.begin() + (i + 1) * chunk.size(), chunk.begin());
+		}
+	}
+private:
+	static int offsetOf(const int& x, const int& y) { return (y & (chunkSize - 1)) * chunkSize + (x & (chunkSize - 1)); }
+	static Chunk filledWith(const T& value) {
+		Chunk chunk;
+		chunk.fill(value);
+		return chunk;
+	}
+
+	T empty;
+	ChunkTable<Chunk> chunks;
+};
+
+class Room; // Used by RoomGenerator, but Room uses RoomGenerator too
+class Player; // Used by Map, but Map uses Player too
+class Map;
+
+class RoomGenerator {
+public:
+	static void generateSafeRoom(Room& room, RandomStream& rng);
+	static void generateDisjointRoom(Room& room, RandomStream& rng);
+	static void generateCorridorRoom(Room& room, Room& fromRoom, Room& toRoom, bool hasWalls);
+	static void generateCaveRoom(Room& room, RandomStream& rng);
+	static void generateBlockerRoom(Room& room, RandomStream& rng);
+private:
+	RoomGenerator(){} // This class provides only static methods - No need to instantiate it
+	static void createWall(Room& room, const std::array<int, 2>& from, const std::array<int, 2>& to, const bool& hasExit, RandomStream& rng);
+};
+
+class Actor {
+public:
+	Actor(ACTOR_TYPE type = ACTOR_TYPE::UNDETERMINED, std::array<int, 2> position = std::array<int, 2>{5, 5});
+	int position[2];
+	char status; // Store tile the entity replaced (floor is underneath the player) - to open way for possible status effects
+	int health;
+	int maxHealth;
+	int speed;
+	int damage;
+	int armor;
+	int range;
+	int speedLimit;
+	void moveActor(const int& xChange, const int& yChange);
+	ACTOR_TYPE type;
+};
+
+class Room {
+public:
+	Room(const int& roomDiameter, const int& roomCenterX, const int& roomCenterY, ROOM_TYPE roomType, RandomStream& rng, std::pmr::memory_resource* memory) : diameter(roomDiameter), wallPositions(memory),
+		actorPositions(memory), pickupPositions(memory), hazardPositions(memory), floorPositions(memory) {
+		center[0] = roomCenterX;
+		center[1] = roomCenterY;
+		switch (roomType) {
+		case ROOM_TYPE::SAFE_ROOM:
+			RoomGenerator::generateSafeRoom(*this, rng);
+			break;
+		case ROOM_TYPE::DISJOINT:
+			RoomGenerator::generateDisjointRoom(*this, rng);
+			break;
+		case ROOM_TYPE::ROOM:
+			RoomGenerator::generateSafeRoom(*this, rng);
+			break;
+		case ROOM_TYPE::CAVE:
+			RoomGenerator::generateSafeRoom(*this, rng);
+			break;
+		}
+	};
+
+	Room(Room& from, Room& to, bool hasWalls, std::pmr::memory_resource* memory) : wallPositions(memory),
+		actorPositions(memory), pickupPositions(memory), hazardPositions(memory), floorPositions(memory) {
+		RoomGenerator::generateCorridorRoom(*this ,from, to, hasWalls);
+	};
+	int diameter;
+	std::array<int, 2> center;
+	std::pmr::vector<std::array<int, 2>> wallPositions;
+	std::pmr::vector<std::array<int, 2>> actorPositions;
+	std::pmr::vector<std::array<int, 2>> pickupPositions;
+	std::pmr::vector<std::array<int, 2>> hazardPositions;
+	std::pmr::vector<std::array<int, 2>> floorPositions;
+};
+
+// Every enemy on a floor, one column per stat - a turn only touches a few stats of each enemy, and those then sit next to each other
+// Enemies are referred to by an id that stays the same for as long as they live. Their slot in the columns moves when another one dies
+class ActorTable {
+public:
+	ActorTable(std::pmr::memory_resource* memory);
+	// Copies the stats of the given actor, returns its id. now is the TurnScheduler's clock, the actor's speed is the energy it has by then
+	int add(const Actor& actor, const int64_t& now);
+	void remove(const int& id);
+	void clear();
+	Actor get(const int& slot, const int64_t& now) const; // The enemy in that slot, as a standalone Actor
+	int slotOf(const int& id) const { return slots[id]; }
+	int size() const { return int(ids.size()); }
+	// Actor::speed - builds up with every player action until it reaches speedLimit, then starts over from what was left
+	// With each action adding less than the limit, that is just the time since energyBase wrapped around it, so nobody has to add it up
+	int energyAt(const int& slot, const int64_t& now) const { return int((now - energyBase[slot]) % speedLimit[slot]); }
+
+	std::pmr::vector<int> positionX;
+	std::pmr::vector<int> positionY;
+	std::pmr::vector<int64_t> energyBase; // When the enemy last had no energy, on the TurnScheduler's clock
+	std::pmr::vector<int> speedLimit;
+	std::pmr::vector<int> health;
+	std::pmr::vector<int> damage;
+	std::pmr::vector<int> armor;
+	std::pmr::vector<int> range;
+	std::pmr::vector<ACTOR_TYPE> type;
+	std::pmr::vector<int> ids; // Which enemy is in each slot
+private:
+	std::pmr::vector<int> slots; // Which slot each id is in, -1 once it died
+};
+
+// Who acts when on a floor. The clock counts in the same units as speeds - every player action moves it on by Player::speed
+// Enemies are filed under the time they are next due, so a turn only looks at those that are, however many there are on the floor
+class TurnScheduler {
+public:
+	TurnScheduler(std::pmr::memory_resource* memory) : clock(0), queue(memory) {}
+	int64_t now() const { return clock; }
+	void advance(const int& duration) { clock += duration; }
+	void schedule(const int& id, const int64_t& time);
+	bool popDue(const int64_t& until, int& id); // Takes the earliest entry due by then - false once there are none. Ties go to the lower id
+	void clear(); // Forgets every entry, but not the time
+	int size() const { return int(queue.size()); }
+private:
+	struct Entry {
+		int64_t time;
+		int id;
+	};
+	static bool isLater(const Entry& entry, const Entry& other) { return entry.time > other.time || (entry.time == other.time && entry.id > other.id); }
+
+	int64_t clock;
+	std::pmr::vector<Entry> queue; // A binary min-heap
+};
+
+// The cells of a map within reach of a point, clipped to the map - searches stay inside one, so they cost the same on any size of map
+class MapWindow {
+public:
+	MapWindow(const int& mapWidth = 0, const int& mapHeight = 0, const int& x = 0, const int& y = 0, const int& reach = 0) :
+		left(std::max(0, x - reach)), top(std::max(0, y - reach)) {
+		width = std::max(0, std::min(mapWidth, x + reach + 1) - left);
+		height = std::max(0, std::min(mapHeight, y + reach + 1) - top);
+	}
+	bool contains(const int& x, const int& y) const { return x >= left && x < left + width && y >= top && y < top + height; }
+	int indexOf(const int& x, const int& y) const { return (y - top) * width + (x - left); }
+	int xOf(const int& index) const { return left + index % width; }
+	int yOf(const int& index) const { return top + index / width; }
+	int size() const { return width * height; }
+
+	int left;
+	int top;
+	int width;
+	int height;
+};
+
+// Which part of a map the play area on screen shows - it follows a point around, and screen cells map to map cells by an offset
+// The view only jumps once the point gets close to its edge, so walking around mostly repaints single cells instead of the whole view
+class Camera {
+public:
+	static constexpr int margin = 10; // How close to the edge of the view the point may get before the view recentres
+
+	Camera(const int& width = PLAY_AREA_WIDTH, const int& height = PLAY_AREA_HEIGHT) : left(0), top(0), width(width), height(height) {}
+	// Centres the view on a point, as far as the map allows - a map smaller than the view sits in its top left corner
+	void centreOn(const int& mapWidth, const int& mapHeight, const int& x, const int& y) {
+		this->left = std::clamp(x - this->width / 2, 0, std::max(0, mapWidth - this->width));
+		this->top = std::clamp(y - this->height / 2, 0, std::max(0, mapHeight - this->height));
+	}
+	// Recentres only if the point got too close to the edge of the view - returns whether the view moved
+	bool follow(const int& mapWidth, const int& mapHeight, const int& x, const int& y) {
+		if (x >= this->left + margin && x < this->left + this->width - margin && y >= this->top + margin && y < this->top + this->height - margin) {
+			return false;
+		}
+		int oldLeft = this->left;
+		int oldTop = this->top;
+		this->centreOn(mapWidth, mapHeight, x, y);
+		return this->left != oldLeft || this->top != oldTop;
+	}
+	bool contains(const int& x, const int& y) const { return x >= left && x < left + width && y >= top && y < top + height; }
+	int screenX(const int& x) const { return x - left; }
+	int screenY(const int& y) const { return y - top; }
+
+	int left;
+	int top;
+	int width;
+	int height;
+};
+
+// How many steps every walkable cell near a single goal is from it, shared by everything chasing it
+// Actors are walked through, so one enemy standing in a corridor doesn't send the rest the long way round
+class DistanceMap {
+public:
+	static constexpr int reach = 128; // Only chasers in sight ever ask, so this is plenty - and covers a whole default map
+	static constexpr int unreachable = (2 * reach + 1) * (2 * reach + 1);
+
+	DistanceMap();
+	// Does nothing unless the goal moved or the terrain changed since the last call
+	void update(const Map& playArea, const int& goalX, const int& goalY);
+	int distanceAt(const int& x, const int& y) const {
+		if (!window.contains(x, y)) {
+			return unreachable;
+		}
+		int distance = distances[paddedIndexOf(x, y)];
+		return distance == blocked ? unreachable : distance;
+	}
+	// The free neighbouring cell closest to the goal, horizontal steps first on a tie
+	// Returns false if every way forward is blocked, or there is none
+	bool stepDownhill(const Map& playArea, const int& x, const int& y, int& xChange, int& yChange) const;
+private:
+	static constexpr int blocked = -1; // Terrain, and the ring of padding around the window
+	void recompute(const Map& playArea);
+	// The window with a cell of padding all round, so the search never has to check where it is
+	int paddedIndexOf(const int& x, const int& y) const { return (y - window.top + 1) * (window.width + 2) + (x - window.left + 1); }
+
+	MapWindow window; // Everything the last search could reach
+	std::vector<int> distances; // Padded, see paddedIndexOf()
+	std::vector<int> frontier; // Every cell is queued at most once, so this never overflows
+	int goalX;
+	int goalY;
+	uint32_t terrainVersion;
+	bool computed;
+};
+
+// Buckets things by position, so asking what is near a cell only looks at the few buckets around it
+// The owner keeps it in sync - every insert, move and remove passes the position the item is filed under
+// Buckets come in blocks covering a map chunk each, and a block is only made once something is filed in it
+template <typename T>
+class SpatialGrid {
+public:
+	static constexpr int cellSize = 8;
+	static constexpr int blockSize = MAP_CHUNK_SIZE / cellSize; // Buckets along one side of a block
+
+	SpatialGrid(std::pmr::memory_resource* memory, const int& width, const int& height) :
+		columns((width + cellSize - 1) / cellSize), rows((height + cellSize - 1) / cellSize),
+		blockColumns((columns + blockSize - 1) / blockSize), blocks(blockColumns * ((rows + blockSize - 1) / blockSize), memory) {}
+	void insert(const T& item, const int& x, const int& y) { bucketAt(x, y).push_back(item); }
+	void remove(const T& item, const int& x, const int& y) {
+		std::pmr::vector<T>& bucket = bucketAt(x, y);
+		for (size_t i = 0; i < bucket.size(); ++i) {
+			if (bucket[i] == item) {
+				bucket[i] = bucket.back(); // Order within a bucket doesn't matter
+				bucket.pop_back();
+				return;
+			}
+		}
+	}
+	void clear() {
+		for (auto& block : blocks) {
+			for (auto& bucket : block) {
+				bucket.clear();
+			}
+		}
+	}
+	void move(const T& item, const int& fromX, const int& fromY, const int& toX, const int& toY) {
+		if (fromX / cellSize == toX / cellSize && fromY / cellSize == toY / cellSize) {
+			return; // Still in the same bucket
+		}
+		remove(item, fromX, fromY);
+		insert(item, toX, toY);
+	}
+	// Calls found(item) for everything in the buckets touching the square of the given range around (x, y)
+	// Items near the edge of those buckets can be further away - the caller checks the exact distance
+	template <typename Callback>
+	void forEachNear(const int& x, const int& y, const int& range, Callback found) const {
+		int fromColumn = std::max(0, (x - range) / cellSize);
+		int toColumn = std::min(columns - 1, (x + range) / cellSize);
+		int fromRow = std::max(0, (y - range) / cellSize);
+		int toRow = std::min(rows - 1, (y + range) / cellSize);
+		for (int row = fromRow; row <= toRow; ++row) {
+			for (int column = fromColumn; column <= toColumn; ++column) {
+				const std::pmr::vector<std::pmr::vector<T>>& block = blocks[blockOf(column, row)];
+				if (block.empty()) {
+					continue; // Nothing was ever filed around here
+				}
+				for (const T& item : block[bucketOf(column, row)]) {
+					found(item);
+				}
+			}
+		}
+	}
+private:
+	int blockOf(const int& column, const int& row) const { return (row / blockSize) * blockColumns + column / blockSize; }
+	static int bucketOf(const int& column, const int& row) { return (row % blockSize) * blockSize + column % blockSize; }
+	std::pmr::vector<T>& bucketAt(const int& x, const int& y) {
+		std::pmr::vector<std::pmr::vector<T>>& block = blocks[blockOf(x / cellSize, y / cellSize)];
+		if (block.empty()) {
+			block.resize(blockSize * blockSize);
+		}
+		return block[bucketOf(x / cellSize, y / cellSize)];
+	}
+
+	int columns;
+	int rows;
+	int blockColumns;
+	std::pmr::vector<std::pmr::vector<std::pmr::vector<T>>> blocks; // Row major, everything allocates from the same resource
+};
+
+// Simply stores current level metadata for better modularity
+class Level {
+public:
+	Level(const int& difficulty, const uint64_t& seed, const int& width, const int& height);
+	static constexpr int maxRooms = 512; // Past this, a bigger map only gets more open ground - rooms are what map chunks get allocated for
+	void generateEasyEnvironment();
+	// void generateMediumEnvironment(); - Here lie the reminders of ambitions of the past
+	// void generateDifficultEnvironment(); - May they rest undisturbed
+
+	int updateEnemies(Map& playArea, Player& player, std::vector<GameEvent>& events); // Returns how many enemies moved
+	// Ranges are Chebyshev, like everywhere else - nearest means closest in a straight line, ties go to whichever is found first
+	// The enemy's id, or -1 if there is nothing to hit
+	int nearestVisibleEnemy(const Map& playArea, const int& x, const int& y, const int& range) const;
+	Pickup* nearestVisiblePickup(const Map& playArea, const int& x, const int& y, const int& range) const;
+	// Both also take the tile off the map
+	void killEnemy(Map& playArea, const int& enemy);
+	int spawnEnemy(const ACTOR_TYPE& type, const std::array<int, 2>& position); // Returns its id, drawEnemies() puts it on the map
+	int spawnEnemy(const Actor& enemy); // Keeps the enemy's stats as they are
+	void spawnPickup(const PICKUP_TYPE& type, const std::array<int, 2>& position); // drawPickups() puts it on the map
+	void removePickup(Map& playArea, Pickup* pickup);
+	void clearEntities(); // Forgets every enemy and pickup, only the rooms stay
+
+	LevelArena arena; // Declared first - everything below lives in it, so it has to outlive them
+	int difficultyLevel;
+	int width; // Of the map it was generated for
+	int height;
+	RandomService rng; // Seeded per floor, so the same run seed always yields the same floor
+	Room* safeRoom;
+	Room* exitRoom;
+	std::pmr::vector<Room*> rooms;
+	std::pmr::vector<Room*> corridors;
+	std::pmr::vector<Pickup*> pickups;
+	ActorTable hostileActors;
+	SpatialGrid<int> enemyGrid; // Same enemies and pickups as above, filed by position
+	SpatialGrid<Pickup*> pickupGrid;
+	DistanceMap pursuit; // Rooted at the player, every enemy on the floor follows it
+	TurnScheduler turns; // The player's actions move its clock on, enemies in sight are filed in it
+private:
+	void populatePickups();
+	void moveEnemy(Map& playArea, const int& slot, const int& xChange, const int& yChange);
+	// Enemies only ever do something in sight, so the rest sleep outside the scheduler until vision finds them
+	void wakeEnemiesInSight(const Map& playArea, const Player& player, const int64_t& turnStart);
+	bool isDue(const int& slot, const int64_t& turnStart, const int& playerSpeed) const;
+	int64_t nextDue(const int& slot, const int64_t& from, const int& playerSpeed) const;
+	void populateEnemies(const int& spawnRate, const int& rangeOfEnemies);
+	// Pickup spawn rate is constant, but enemy spawn rate needs control
+	// We also want to control what kinds of enemies to spawn
+
+	std::pmr::vector<bool> awake; // By enemy id - whether it is filed in turns
+	std::pmr::vector<int> dueEnemies; // Slots, reused every turn
+};
+
+// Index of the lowest set bit - the word must not be zero
+static inline int lowestSetBit(const uint64_t& word) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return int(index);
+#else
+	return __builtin_ctzll(word);
+#endif
+}
+
+// What the player sees right now and what they have ever seen, one bit per cell
+// Kept in chunks, so only the part of the map ever seen takes memory. Each row of a chunk is a single word, tested or cleared at once
+class VisibilityPlanes {
+public:
+	static constexpr int chunkSize = MAP_CHUNK_SIZE;
+	static_assert(chunkSize == 32, "A chunk row has to fit a uint32_t exactly");
+	struct Chunk {
+		std::array<uint32_t, chunkSize> visible;
+		std::array<uint32_t, chunkSize> seen; // Does not include what is visible right now
+		bool lit; // Anything visible in it - only these are visited when sight resets
+	};
+
+	VisibilityPlanes() : chunks(Chunk{}) {}
+
+	void reset(const int& width, const int& height) {
+		chunks.reset(width, height);
+		litChunks.clear();
+	}
+	bool isVisible(const int& x, const int& y) const {
+		const Chunk& chunk = chunks.find(x, y);
+		return (chunk.visible[y & (chunkSize - 1)] >> (x & (chunkSize - 1))) & 1u;
+	}
+	bool isSeen(const int& x, const int& y) const {
+		const Chunk& chunk = chunks.find(x, y);
+		return ((chunk.visible[y & (chunkSize - 1)] | chunk.seen[y & (chunkSize - 1)]) >> (x & (chunkSize - 1))) & 1u;
+	}
+	// 0 never seen, 1 seen before but out of sight, 2 in sight
+	int stateOf(const int& x, const int& y) const { return isVisible(x, y) ? 2 : (isSeen(x, y) ? 1 : 0); }
+	// A whole row of a chunk at once - bit i is the cell i to the right of the chunk's left edge. Chunks never seen read as 0
+	int chunkOf(const int& x, const int& y) const { return chunks.indexOf(x, y); }
+	uint32_t visibleMask(const int& chunk, const int& row) const { return chunks.chunkAt(chunk).visible[row]; }
+	uint32_t seenMask(const int& chunk, const int& row) const { return chunks.chunkAt(chunk).seen[row]; } // Does not include what is visible right now
+	// Returns whether the bit actually changed
+	bool setVisible(const int& x, const int& y) {
+		Chunk& chunk = chunks.at(x, y);
+		uint32_t& word = chunk.visible[y & (chunkSize - 1)];
+		uint32_t bit = uint32_t(1) << (x & (chunkSize - 1));
+		if ((word & bit) != 0) {
+			return false;
+		}
+		word |= bit;
+		if (!chunk.lit) {
+			chunk.lit = true;
+			litChunks.push_back(chunks.indexOf(x, y));
+		}
+		return true;
+	}
+	// Everything visible becomes merely seen. onHidden(x, y) is called for each cell that left sight
+	template <typename Callback>
+	void resetVisible(Callback onHidden) {
+		for (auto& index : litChunks) {
+			Chunk& chunk = chunks.allocate(index); // Long since allocated, this only finds it
+			int left = chunks.leftOf(index);
+			int top = chunks.topOf(index);
+			for (int row = 0; row < chunkSize; ++row) {
+				uint32_t bits = chunk.visible[row];
+				while (bits != 0) {
+					onHidden(left + lowestSetBit(bits), top + row);
+					bits &= bits - 1;
+				}
+			}
+			for (int row = 0; row < chunkSize; ++row) { // Separate loop, so this part vectorizes
+				chunk.seen[row] |= chunk.visible[row];
+				chunk.visible[row] = 0;
+			}
+			chunk.lit = false;
+		}
+		litChunks.clear();
+	}
+	int chunkCount() const { return chunks.chunkCount(); }
+	int chunksAllocated() const { return int(chunks.allocatedChunks().size()); }
+	// Like ChunkedGrid - an index per allocated chunk, and chunkSize words of each plane per index
+	void exportChunks(std::vector<int>& indices, std::vector<uint32_t>& visibleWords, std::vector<uint32_t>& seenWords) const {
+		indices = chunks.allocatedChunks();
+		visibleWords.clear();
+		seenWords.clear();
+		for (auto& index : indices) {
+			const Chunk& chunk = chunks.chunkAt(index);
+			visibleWords.insert(visibleWords.end(), chunk.visible.begin(), chunk.visible.end());
+			seenWords.insert(seenWords.end(), chunk.seen.begin(), chunk.seen.end());
+		}
+	}
+	void importChunks(const std::vector<int>& indices, const std::vector<uint32_t>& visibleWords, const std::vector<uint32_t>& seenWords) {
+		for (size_t i = 0; i < indices.size(); ++i) {
+			Chunk& chunk = chunks.allocate(indices[i]);
+			std::copy(visibleWords.begin() + i * chunkSize, visibleWords.begin() + (i + 1) * chunkSize, chunk.visible.begin());
+			std::copy(seenWords.begin() + i * chunkSize, seenWords.begin() + (i + 1) * chunkSize, chunk.seen.begin());
+			chunk.lit = false;
+			for (auto& word : chunk.visible) {
+				chunk.lit = chunk.lit || word != 0;
+			}
+			if (chunk.lit) {
+				litChunks.push_back(indices[i]);
+			}
+		}
+	}
+private:
+	ChunkTable<Chunk> chunks;
+	std::vector<int> litChunks;
+};
+
+// The state of the play area - drawing it to a console is PlayAreaSection's job
+// Its size is picked at runtime; cells only take memory once something other than floor is put there, or they are seen
+class Map {
+public:
+	Map(const uint64_t& runSeed, const int& width = PLAY_AREA_WIDTH, const int& height = PLAY_AREA_HEIGHT, FLOOR_GENERATION floorGeneration = FLOOR_GENERATION::PREFETCHED);
+	~Map();
+	Map(const Map&) = delete; // Owns its level
+	Map& operator=(const Map&) = delete;
+	void setupNewPlayArea(Player& player);
+	// Clamped to MIN_MAP_SIZE..MAX_MAP_SIZE. Empties the map - the next generated floor has the new size
+	void setSize(const int& width, const int& height);
+	bool isOnMap(const int& x, const int& y) const { return x >= 0 && x < width && y >= 0 && y < height; }
+	// The edge of the map is always wall, and so is everything past it
+	char tileAt(const int& x, const int& y) const {
+		return x > 0 && x < width - 1 && y > 0 && y < height - 1 ? tiles.get(x, y) : Tileset::wall;
+	}
+	// Anything off the map blocks both
+	bool isSightBlocker(const int& x, const int& y) const { return TileProperties::has(tileAt(x, y), TileProperties::blocksSight); }
+	bool isMovementBlocker(const int& x, const int& y) const { return TileProperties::has(tileAt(x, y), TileProperties::blocksMovement); }
+	// Blocks movement for good - walls and pickups, but not actors, who will eventually step aside
+	bool isTerrainBlocker(const int& x, const int& y) const {
+		uint16_t properties = TileProperties::of(tileAt(x, y));
+		return (properties & TileProperties::blocksMovement) != 0 && (properties & TileProperties::isActor) == 0;
+	}
+	void resetActiveSight();
+	void generateNewLevel(const int& difficultyLevel);
+	void drawRooms();
+	void drawPickups();
+	void drawEnemies();
+	// All writes to tiles and visibility go through these, so the renderer knows which cells to repaint
+	void setTile(const int& x, const int& y, const char& tile); // The edge of the map stays as it is
+	void setVisible(const int& x, const int& y);
+	void markAllDirty();
+	void clearDirty();
+
+	int width;
+	int height;
+	VisibilityPlanes visibility;
+	ChunkedGrid<char> tiles; // Read through tileAt(), which knows about the edge
+	uint64_t runSeed; // Every floor seed is derived from this
+	Level* level;
+	FLOOR_GENERATION floorGeneration;
+	std::future<Level*> nextLevel; // Generated on a worker thread while the current floor is played - only when PREFETCHED
+	uint32_t terrainVersion; // Bumped whenever a terrain blocker appears or disappears
+	std::vector<std::array<int, 2>> dirtyCells; // Changed since the last clearDirty(), each listed once
+	bool wholeMapDirty; // Too much changed to bother listing - e.g. a new floor
+private:
+	void markDirty(const int& x, const int& y);
+	void prefetchLevel(const int& difficultyLevel);
+	ChunkedGrid<bool> dirty;
+};
+
+class FieldOfView {
+public:
+	// Slopes are kept as exact fractions - floating point would make symmetry depend on rounding
+	struct Slope {
+		int numerator;
+		int denominator; // Always positive
+	};
+	// One row of a quadrant, scanned between two slopes
+	struct Row {
+		int depth;
+		Slope start;
+		Slope end;
+	};
+
+	// Symmetric shadowcasting - if a tile can see another, the other sees it too, and nothing within the radius slips between rays
+	// Marks everything in sight as visible in a single pass
+	void compute(Map& playArea, const int& originX, const int& originY, const int& radius);
+private:
+	std::vector<Row> rows; // Rows still to scan - kept between calls, so a turn doesn't allocate them again
+};
+
+class Player : public Actor {
+public:
+	static constexpr int minSpeed = 5; // Every action has to take some time, or the TurnScheduler's clock would stand still
+	Player();
+	void placeSelf(Map& playArea, int x, int y);
+	void recalculateActiveSight(Map& playArea);
+	void playerInterract(Pickup& pickup);
+	int sightRadius;
+	FieldOfView fieldOfView;
+};
+
+// Everything needed to continue a run later. The rooms aren't in it - the floor is generated again from the run seed
+struct GameSnapshot {
+	uint64_t runSeed;
+	int difficultyLevel;
+	GAME_STATUS status;
+	Player player;
+	int width;
+	int height;
+	std::vector<int> tileChunks; // The chunks of Map::tiles anything was written to, see ChunkedGrid::exportChunks
+	std::vector<char> tiles;
+	std::vector<int> sightChunks; // Same for the visibility planes
+	std::vector<uint32_t> visible;
+	std::vector<uint32_t> seen;
+	std::vector<Pickup> pickups;
+	std::vector<Actor> enemies; // In turn order
+};
+
+// Keeps the time spent in each phase over the last few frames
+// Phases can be added to several times per frame, finishFrame() then files the totals away
+class TurnProfiler {
+public:
+	static constexpr int historyLength = 128;
+
+	TurnProfiler();
+	void add(const TURN_PHASE& phase, const long long& nanoseconds) { current[int(phase)] += nanoseconds; }
+	void finishFrame();
+	long long last(const TURN_PHASE& phase) const;
+	long long percentile99(const TURN_PHASE& phase) const; // Sorts a copy of the history - meant for the overlay, not every turn
+private:
+	std::array<std::array<long long, historyLength>, int(TURN_PHASE::_count)> history;
+	std::array<long long, int(TURN_PHASE::_count)> current;
+	int frames; // How many frames were finished in total
+};
+
+// Adds the time until it goes out of scope to a phase. Does nothing without a profiler, so headless runs don't pay for the clock
+class ProfileScope {
+public:
+	ProfileScope(TurnProfiler* profiler, const TURN_PHASE& phase) : profiler(profiler), phase(phase) {
+		if (profiler != nullptr) {
+			start = std::chrono::steady_clock::now();
+		}
+	}
+	~ProfileScope() {
+		if (profiler != nullptr) {
+			profiler->add(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+		}
+	}
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+private:
+	TurnProfiler* profiler;
+	TURN_PHASE phase;
+	std::chrono::steady_clock::time_point start;
+};
+
+// A whole run without any presentation attached
+// Front-ends feed it actions and react to the events it leaves behind
+class Simulation {
+public:
+	Simulation(const uint64_t& seed, const int& width = PLAY_AREA_WIDTH, const int& height = PLAY_AREA_HEIGHT, FLOOR_GENERATION floorGeneration = FLOOR_GENERATION::PREFETCHED);
+	void step(PLAYER_ACTION action);
+	std::vector<GameEvent> takeEvents(); // Hands the accumulated events over and starts a fresh batch
+	void takeEvents(std::vector<GameEvent>& taken); // The same, but the next batch goes into the old buffer of taken - no allocations once both have grown
+	uint64_t stateHash() const; // Two runs that played out the same end with the same hash
+	GameSnapshot snapshot() const;
+	void restore(const GameSnapshot& snapshot); // Carries on exactly as the snapshotted run would have
+
+	Map playArea;
+	std::shared_ptr<Player> player;
+	GAME_STATUS status;
+	std::vector<GameEvent> events;
+	TurnProfiler* profiler; // Optional, owned by whoever wants the timings
+private:
+	void playerMove(DIRECTIONS direction);
+	void playerInterract();
+	void setupNewFloor();
+	void endTurn(); // Enemies act, death is checked and the player's vision is refreshed
+};
+
+// Plays the game through the same actions a player has, and only knows what the player has seen
+// Fights whatever is in reach, then collects every pickup it knows of, then takes the exit, exploring when it knows of neither
+class AutoPlayer {
+public:
+	PLAYER_ACTION chooseAction(const Simulation& simulation);
+private:
+	// How far from the player a search starts out - a whole default map, but not all of a huge one
+	// When nothing to go for is within it, the search goes again twice as far, until it covers the map
+	static constexpr int reach = 128;
+	// Breadth-first over the seen floor within reach of the player. Goals are cells of the window, -1 if there is none. Returns the player's cell
+	int search(const Map& playArea, const Player& player, const int& reach, int& pickupGoal, int& exitGoal, int& unexploredGoal);
+	MapWindow window;
+	std::vector<int> parents; // Breadth-first search state, kept between turns so it isn't reallocated
+	std::vector<int> frontier;
+	int fallbackDirection = 0; // Nothing left to explore - wander around in a circle
+};
+
+// A session as its seed plus every action taken, which is all it takes to play it again exactly
+// On disk: "CRRP", a version byte, the seed, the map size, then one byte per action. Closing cleanly appends 0xFF, the action count and the final state hash
+// Version 1 logs have no map size - they were all played on the default one
+class ReplayLog {
+public:
+	static constexpr uint8_t version = 2;
+
+	ReplayLog(const uint64_t& seed = 0, const int& width = PLAY_AREA_WIDTH, const int& height = PLAY_AREA_HEIGHT) :
+		seed(seed), width(width), height(height), hasFinalState(false), finalHash(0) {}
+	bool startRecording(const std::string& path); // Returns false if the file can't be written. Actions recorded so far are written too
+	void record(const PLAYER_ACTION& action); // Flushed right away - a crash still leaves every action up to it
+	void finishRecording(const uint64_t& stateHash);
+	bool load(const std::string& path); // Returns false if it isn't a replay this version understands
+	void play(Simulation& simulation) const; // Steps through every action, nothing else - as fast as the CPU allows
+
+	uint64_t seed;
+	int width; // Of the map, which the Simulation playing it back has to be made with
+	int height;
+	std::vector<PLAYER_ACTION> actions;
+	bool hasFinalState; // Only a cleanly closed session knows how it ended
+	uint64_t finalHash;
+private:
+	std::ofstream out;
+};
+
+#endif
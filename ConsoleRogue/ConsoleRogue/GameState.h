@@ -4,98 +4,22 @@
 #define CONSOLE_WIDTH 100
 #define CONSOLE_HEIGHT 80
 
-#define PLAY_AREA_HEIGHT 60
-#define PLAY_AREA_WIDTH 80
-
 #define STAT_AREA_WIDTH 40
 #define STAT_AREA_HEIGHT 60
 
 #define EVENT_AREA_WIDTH 100
 #define EVENT_AREA_HEIGHT 40
 
+#define AUTOSAVE_FILE "autosave.sav" // Written on every new floor and on quit, picked up again on the next start
+
+#include "GameCore.h"
 #include "libtcod.hpp"
 #include "SDL.h"
 // SDL defines main and causes errors
 #undef main
 #include <vector>
-#include <random>
-#include <deque>
 #include <iostream>
 
-static int getRandomNumber(const int& from, const int& to) {
-	int low = from;
-	int high = to;
-	if (from > to) { // Preventing headaches from misordered parameters
-		low = to;
-		high = from;
-	}
-	std::random_device rd; // obtain a random number from hardware
-	std::mt19937 gen(rd()); // seed the generator
-	std::uniform_int_distribution<> distr(low, high); // define the range
-	return distr(gen);
-}
-
-enum class DIRECTIONS {
-	MOVE_UP,
-	MOVE_DOWN,
-	MOVE_LEFT,
-	MOVE_RIGHT,
-};
-
-enum class ROOM_TYPE {
-	CORRIDOR,
-	CAVE,
-	ROOM,
-	BLOCKER,
-	DISJOINT,
-	SAFE_ROOM,
-};
-
-// Not treating exit as a pickup would introduce pointless extra complexity. It behaves like one, we just don't randomly generate more
-enum class PICKUP_TYPE {
-	EXIT = 0,
-	DAMAGE = 1,
-	ARMOR = 2,
-	SPEED = 3,
-	HEALTH_REFILL = 4,
-	HEALTH_UPGRADE = 5,
-	RANGE = 6,
-	_count = 7,
-};
-
-enum class ACTOR_TYPE {
-	GOBLIN = 0,
-	UNDETERMINED = 1,
-	_count = 2,
-};
-
-// Simply store all used characters here for easy global changes
-class Tileset {
-public:
-	static const char wall = '#';
-	static const char goblin = 'G';
-	static const char player = '@';
-	static const char floor = '.';
-	static const char exit = 'E';
-	static const char damagePickup = 'D';
-	static const char speedPickup = 'S';
-	static const char armorPickup = 'A';
-	static const char healthRefillPickup = 'H';
-	static const char healthUpgradePickup = 'M';
-	static const char rangePickup = 'R';
-private:
-	// This class only holds static data
-	// Forbid creating its instances
-	Tileset() {}
-};
-
-class Pickup {
-public:
-	Pickup(PICKUP_TYPE type, std::array<int, 2> position) : type(type), position(position) {}
-	PICKUP_TYPE type;
-	std::array<int, 2> position;
-};
-
 class Palette {
 public:
 	Palette(){
@@ -111,6 +35,7 @@ public:
 		inSightPickup = tcod::ColorRGB(255, 255, 0); // Yellow #ffff00
 		outOfSightPickup = tcod::ColorRGB(179, 179, 0); // Yellow #b3b300
 		goblin = tcod::ColorRGB(255, 0, 0); // Red #ff0000
+		playAreaBackground = tcod::ColorRGB(0, 0, 0); // Black #000000
 	}
 	tcod::ColorRGB inSightWoodWall;
 	tcod::ColorRGB outOfSightWoodWall;
@@ -124,180 +49,176 @@ public:
 	tcod::ColorRGB outOfSightPickup;
 	tcod::ColorRGB inSightPickup;
 	tcod::ColorRGB goblin;
+	tcod::ColorRGB playAreaBackground;
 };
 
-class Room; // Used by RoomGenerator, but Room uses RoomGenerator too
-class Player; // Used by Map, but Map uses Player too
-class Map;
-
-class EventSection {
-public:
-	EventSection(const std::shared_ptr<Palette> palette) : palette(palette) {}
-	void colorArea(tcod::Console& console, tcod::ContextPtr& context);
-	void newEvent(tcod::Console& console, tcod::ContextPtr& context, std::string eventDescription);
-private:
-	// TODO: Make types of events so they could be drawn in different colors?
-	// Could possibly remove the need for a palette pointer
-	void drawEvents(tcod::Console& console, tcod::ContextPtr& context);
-	std::shared_ptr<Palette> palette;
-	std::deque<std::string> events;
+// Everything the event section can say - the text of each is in EventSection.cpp, some have a number to fill in
+enum class LOG_MESSAGE {
+	MOVED_NORTH,
+	MOVED_SOUTH,
+	MOVED_WEST,
+	MOVED_EAST,
+	DAMAGED_GOBLIN, // argument: damage dealt
+	KILLED_GOBLIN,
+	DAMAGED_BY_GOBLIN, // argument: damage taken
+	ENTERED_FLOOR,
+	_count,
 };
 
-class RoomGenerator {
-public:
-	static void generateSafeRoom(Room& room);
-	static void generateDisjointRoom(Room& room);
-	static void generateCorridorRoom(Room& room, Room& fromRoom, Room& toRoom, bool hasWalls);
-	static void generateCaveRoom(Room& room);
-	static void generateBlockerRoom(Room& room);
-private:
-	RoomGenerator(){} // This class provides only static methods - No need to instantiate it
-	static void createWall(Room& room, const std::array<int, 2>& from, const std::array<int, 2>& to, const bool& hasExit);
+struct LogEntry {
+	LOG_MESSAGE message;
+	int argument;
+	bool operator==(const LogEntry& other) const { return message == other.message && argument == other.argument; }
 };
 
-class Actor {
+// The last few messages, oldest first, kept as what to say rather than the text - a fixed ring, so logging never allocates
+class EventLog {
 public:
-	Actor(ACTOR_TYPE type = ACTOR_TYPE::UNDETERMINED, std::array<int, 2> position = std::array<int, 2>{5, 5});
-	int position[2];
-	char status; // Store tile the entity replaced (floor is underneath the player) - to open way for possible status effects
-	int health;
-	int maxHealth;
-	int speed;
-	int damage;
-	int armor;
-	int range;
-	int speedLimit;
-	void moveActor(const int& xChange, const int& yChange);
-	ACTOR_TYPE type;
-};
+	static constexpr int capacity = 5;
 
-class Room {
-public:
-	Room(const int& roomDiameter, const int& roomCenterX, const int& roomCenterY, ROOM_TYPE roomType) : diameter(roomDiameter), wallPositions(), 
-		actorPositions(), pickupPositions(), hazardPositions(), floorPositions() {
-		center[0] = roomCenterX;
-		center[1] = roomCenterY;
-		switch (roomType) {
-		case ROOM_TYPE::SAFE_ROOM:
-			RoomGenerator::generateSafeRoom(*this);
-			break;
-		case ROOM_TYPE::DISJOINT:
-			RoomGenerator::generateDisjointRoom(*this);
-			break;
-		case ROOM_TYPE::ROOM:
-			RoomGenerator::generateSafeRoom(*this);
-			break;
-		case ROOM_TYPE::CAVE:
-			RoomGenerator::generateSafeRoom(*this);
-			break;
+	EventLog() : first(0), count(0) {}
+	void add(const LogEntry& entry) { // Pushes the oldest one out once full
+		if (this->count < capacity) {
+			this->entries[(this->first + this->count) % capacity] = entry;
+			++this->count;
 		}
-	};
-
-	Room(Room& from, Room& to, bool hasWalls) : wallPositions(),
-		actorPositions(), pickupPositions(), hazardPositions(), floorPositions() {
-		RoomGenerator::generateCorridorRoom(*this ,from, to, hasWalls);
-	};
-	int diameter;
-	std::array<int, 2> center;
-	std::vector<std::array<int, 2>> wallPositions;
-	std::vector<std::array<int, 2>> actorPositions;
-	std::vector<std::array<int, 2>> pickupPositions;
-	std::vector<std::array<int, 2>> hazardPositions;
-	std::vector<std::array<int, 2>> floorPositions;
-};
-
-// Simply stores current level metadata for better modularity
-class Level {
-public:
-	Level(tcod::ColorRGB inSightWall, const tcod::ColorRGB& outOfSightWall,
-		const tcod::ColorRGB& inSightFloor, const tcod::ColorRGB& outOfSightFloor,
-		const tcod::ColorRGB& outOfSightPickup, const tcod::ColorRGB& inSightPickup, const int& difficulty);
-	void generateEasyEnvironment();
-	// void generateMediumEnvironment(); - Here lie the reminders of ambitions of the past
-	// void generateDifficultEnvironment(); - May they rest undisturbed
-
-	void updateEnemies(Map& playArea, std::shared_ptr<Player> player, EventSection& events, tcod::Console& console, tcod::ContextPtr& context);
-
-	int difficultyLevel;
-	Room* safeRoom;
-	Room* exitRoom;
-	std::vector<Room*> rooms;
-	std::vector<Room*> corridors;
-	std::vector<Pickup*> pickups;
-	std::vector<Actor*> hostileActors;
-	const tcod::ColorRGB& inSightWall;
-	const tcod::ColorRGB& outOfSightWall;
-	const tcod::ColorRGB& inSightFloor;
-	const tcod::ColorRGB& outOfSightFloor;
-	const tcod::ColorRGB& inSightPickup;
-	const tcod::ColorRGB& outOfSightPickup;
+		else {
+			this->entries[this->first] = entry;
+			this->first = (this->first + 1) % capacity;
+		}
+	}
+	void clear() { this->first = 0; this->count = 0; }
+	int size() const { return this->count; }
+	const LogEntry& operator[](const int& i) const { return this->entries[(this->first + i) % capacity]; } // 0 is the oldest
+	bool operator==(const EventLog& other) const {
+		if (this->count != other.count) {
+			return false;
+		}
+		for (int i = 0; i < this->count; ++i) {
+			if (!((*this)[i] == other[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+	bool operator!=(const EventLog& other) const { return !(*this == other); }
 private:
-	void populatePickups();
-	void populateEnemies(const int& spawnRate, const int& rangeOfEnemies); 
-	// Pickup spawn rate is constant, but enemy spawn rate needs control
-	// We also want to control what kinds of enemies to spawn
+	std::array<LogEntry, capacity> entries;
+	int first;
+	int count;
 };
 
-class Map {
+// Both side panels draw into a console of their own, and only when what they show changed
+// draw() copies that console into the main one when it changed - or when forced, because the main console was cleared or drawn over
+class EventSection {
 public:
-	Map(const std::shared_ptr<Palette> palette);
-	void setupNewPlayArea(Player& player, tcod::Console& console, tcod::ContextPtr& context);
-	void drawWholeMap(tcod::Console& console, tcod::ContextPtr& context);
-	void setSingleTile(tcod::Console& console, const int& x, const int& y);
-	bool isSightBlocker(const int& x, const int& y);
-	void resetActiveSight();
-	void generateNewLevel(const int& difficultyLevel);
-	void drawRooms();
-	void drawPickups();
-	void drawEnemies();
-
-	int visited[PLAY_AREA_WIDTH][PLAY_AREA_HEIGHT];
-	char tiles[PLAY_AREA_WIDTH][PLAY_AREA_HEIGHT];
-	std::vector<char> sightBlockers;
+	EventSection(const std::shared_ptr<Palette> palette) : palette(palette), panel(EVENT_AREA_WIDTH, EVENT_AREA_HEIGHT), panelDrawn(false) {}
+	void newEvent(const LOG_MESSAGE& message, const int& argument = 0);
+	const EventLog& getEvents() const { return this->events; }
+	void restoreEvents(const EventLog& events);
+	void draw(tcod::Console& console, const bool& force = false);
+private:
+	// TODO: Make types of events so they could be drawn in different colors?
+	// Could possibly remove the need for a palette pointer
+	void drawPanel(); // The only place messages are turned into text
 	std::shared_ptr<Palette> palette;
-	Level* level;
+	EventLog events;
+	tcod::Console panel;
+	EventLog shownEvents; // What the panel shows - the same message again doesn't change it once the log is full of it
+	bool panelDrawn;
 };
 
-class Player : public Actor {
+// Draws the Map into the play area of the console
+class PlayAreaSection {
 public:
-	Player();
-	void placeSelf(Map& playArea, int x, int y);
-	void recalculateActiveSight(Map& playArea);
-	void playerInterract(Pickup& pickup);
-	
+	PlayAreaSection(const std::shared_ptr<Palette> palette);
+	// Both keep the camera on the player. Map coordinates go in, the camera decides where on screen they land
+	void drawWholeMap(tcod::Console& console, Map& playArea, const Player& player);
+	void drawChangedTiles(tcod::Console& console, Map& playArea, const Player& player); // Only repaints what the Map marked dirty, unless the camera moved
+	void setSingleTile(tcod::Console& console, Map& playArea, const int& x, const int& y);
+
+	Camera camera;
 private:
-	std::vector<std::vector<std::array<int, 2>>> dirsToCheck;
-	
+	void drawView(tcod::Console& console, Map& playArea, const Player& player);
+	// Walls and floors under the camera, one layer per visibility state - only redone when the camera moves or a floor is set up
+	void drawTerrain(Map& playArea);
+	// What a cell looks like on screen, for every glyph and visibility state (0 never seen, 1 seen, 2 in sight) - built once from the palette
+	void buildLooks();
+	const TCOD_ConsoleTile& lookOf(const Map& playArea, const int& x, const int& y) const {
+		return this->looks[(unsigned char)playArea.tileAt(x, y) * 3 + playArea.visibility.stateOf(x, y)];
+	}
+
+	std::shared_ptr<Palette> palette;
+	std::array<TCOD_ConsoleTile, 256 * 3> looks;
+	std::array<tcod::Console, 3> terrainLayers; // Indexed by visibility state, the size of the view
+	bool terrainDrawn;
+	int terrainLeft; // Where the camera was when the layers were drawn
+	int terrainTop;
 };
 
 class PlayerStatSection {
 public:
-	PlayerStatSection(const std::shared_ptr<Palette> palette) : palette(palette) {}
-	void setPlayer(const std::shared_ptr<Player> player) { this->player = player; }
-	void colorArea(tcod::Console& console, tcod::ContextPtr& context);
-	void drawTextFields(tcod::Console& console, tcod::ContextPtr& context);
-	void drawStatValues(tcod::Console& console, tcod::ContextPtr& context);
+	PlayerStatSection(const std::shared_ptr<Palette> palette) : palette(palette), panel(STAT_AREA_WIDTH, STAT_AREA_HEIGHT), shownStats{}, panelDrawn(false) {}
+	void setPlayer(const std::shared_ptr<Player> player) { this->player = player; this->panelDrawn = false; }
+	void draw(tcod::Console& console, const bool& force = false); // Same as EventSection::draw()
+	// Timings of the last frame and the slowest 1% of recent ones, drawn over the bottom of the section
+	void drawProfilerOverlay(tcod::Console& console, const TurnProfiler& profiler, const int& presentsPerTurn, const Level& level);
 private:
+	std::array<int, 6> currentStats() const; // Everything the panel shows, in the order it shows it
+	void drawPanel();
+
 	std::shared_ptr<Palette> palette;
 	std::shared_ptr<Player> player;
+	tcod::Console panel;
+	std::array<int, 6> shownStats;
+	bool panelDrawn;
 };
 
 
 
+// A run on disk - a GameSnapshot plus what only the front-end knows, compressed with TCODZip
+// Everything is read back in the order it was written, so the version has to change whenever the order does
+class SaveGame {
+public:
+	static constexpr int version = 3;
+	static bool write(const std::string& path, const GameSnapshot& snapshot, const EventLog& eventLog, const std::vector<PLAYER_ACTION>& actions);
+	// Returns false, leaving the arguments in an unknown state, if the file is missing, damaged or from another version
+	static bool read(const std::string& path, GameSnapshot& snapshot, EventLog& eventLog, std::vector<PLAYER_ACTION>& actions);
+private:
+	SaveGame() {} // This class provides only static methods
+};
+
 class Game {
 public:
-	Game(const std::shared_ptr<Palette> palette);
-	void playerMove(DIRECTIONS direction);
-	void playerInterract();
-	void setupNewFloor();
+	Game(const std::shared_ptr<Palette> palette, const uint64_t& seed, const int& width = PLAY_AREA_WIDTH, const int& height = PLAY_AREA_HEIGHT);
+	void playerAction(PLAYER_ACTION action);
+	// Draw routines only write to the console - the window is updated here, once per batch of input
+	void presentFrame();
+	void toggleProfilerOverlay();
+	bool startRecording(const std::string& path) { return this->replay.startRecording(path); }
+	void endSession(); // Closes the recording with the final state, so a replay can check it ended the same way
+	bool saveGame(const std::string& path);
+	bool loadGame(const std::string& path); // Must come before startRecording(), the recording carries on from the saved actions
+	TurnProfiler* getProfiler() { return &this->profiler; }
+	const Simulation& getSimulation() const { return this->simulation; }
 private:
+	void drawNewFloor();
+	void drawTurn(); // Reacts to whatever the simulation reported during the last step
 	tcod::Console console;
 	tcod::ContextPtr context;
-	Map playArea;
-	std::shared_ptr<Player> player;
+	Simulation simulation;
+	PlayAreaSection playAreaSection;
 	PlayerStatSection statSection;
 	EventSection eventSection;
 	std::shared_ptr<Palette> palette;
+	bool frameChanged; // Nothing to present if no draw routine ran since the last frame
+	int presentsThisTurn;
+	int presentsLastTurn;
+	TurnProfiler profiler; // Always recording, so the overlay has a history as soon as it is shown
+	bool showProfilerOverlay;
+	ReplayLog replay; // Every action of the session, in order
+	int floorSaved; // The autosave happens once per floor
+	std::vector<GameEvent> turnEvents; // Reused turn after turn, so a busy turn doesn't allocate
 };
 
 #endif 
\ No newline at end of file
@@ -1,39 +1,43 @@
-#include "GameState.h"
-#include "libtcod.hpp"
-#include "SDL.h"
+#include "GameCore.h"
 #include <vector>
+#include <algorithm>
 
-Level::Level(tcod::ColorRGB inSightWall, const tcod::ColorRGB& outOfSightWall,
-	const tcod::ColorRGB& inSightFloor, const tcod::ColorRGB& outOfSightFloor,
-	const tcod::ColorRGB& outOfSightPickup, const tcod::ColorRGB& inSightPickup, const int& difficulty) :
-	inSightWall(inSightWall),
-	inSightFloor(inSightFloor),
-	outOfSightWall(outOfSightWall),
-	outOfSightFloor(outOfSightFloor),
+Level::Level(const int& difficulty, const uint64_t& seed, const int& width, const int& height) :
 	difficultyLevel(difficulty),
-	inSightPickup(inSightPickup),
-	outOfSightPickup(outOfSightPickup)
+	width(width),
+	height(height),
+	rng(seed),
+	rooms(&arena),
+	corridors(&arena),
+	pickups(&arena),
+	hostileActors(&arena),
+	enemyGrid(&arena, width, height),
+	pickupGrid(&arena, width, height),
+	turns(&arena),
+	awake(&arena),
+	dueEnemies(&arena)
 {
+	RandomStream& placement = rng.get(RNG_STREAM::ROOM_PLACEMENT);
 	int xPolarity;
-	if (getRandomNumber(1, 2) % 2 == 0) {
+	if (placement.getNumber(1, 2) % 2 == 0) {
 		xPolarity = -1;
 	}
 	else {
 		xPolarity = 1;
 	}
 	int yPolarity;
-	if (getRandomNumber(1, 2) % 2 == 0) {
+	if (placement.getNumber(1, 2) % 2 == 0) {
 		yPolarity = -1;
 	}
 	else {
 		yPolarity = 1;
 	}
 
-	safeRoom = new Room(4, PLAY_AREA_WIDTH / 2, PLAY_AREA_HEIGHT / 2, ROOM_TYPE::SAFE_ROOM); // Safe room is always the same
-	exitRoom = new Room(4, (PLAY_AREA_WIDTH / 2) + xPolarity * getRandomNumber(9, (PLAY_AREA_WIDTH / 2) - 5), (PLAY_AREA_HEIGHT / 2) + yPolarity * getRandomNumber(9, (PLAY_AREA_HEIGHT / 2) - 5), ROOM_TYPE::SAFE_ROOM);
+	safeRoom = arena.create<Room>(4, width / 2, height / 2, ROOM_TYPE::SAFE_ROOM, placement, &arena); // Safe room is always the same
+	exitRoom = arena.create<Room>(4, (width / 2) + xPolarity * placement.getNumber(9, (width / 2) - 5), (height / 2) + yPolarity * placement.getNumber(9, (height / 2) - 5), ROOM_TYPE::SAFE_ROOM, placement, &arena);
 
-	if (difficultyLevel < 3) {
-		corridors.push_back(new Room(*safeRoom, *exitRoom, false));
+	if (difficultyLevel < WINNING_FLOOR) {
+		corridors.push_back(arena.create<Room>(*safeRoom, *exitRoom, false, &arena));
 		this->generateEasyEnvironment();
 	}
 	/*			else if (difficultyLevel > 2 && difficultyLevel < 6) {
@@ -47,10 +51,11 @@ Level::Level(tcod::ColorRGB inSightWall, const tcod::ColorRGB& outOfSightWall,
 
 // TODO: Create a balancing struct containing all the values to be plugged into generating new levels for better modularity
 void Level::generateEasyEnvironment() {
-	int lowLimitOfRooms = PLAY_AREA_WIDTH / 7; // Entirely arbitrary
-	int highLimitOfRooms = lowLimitOfRooms * (PLAY_AREA_HEIGHT / 10); // The idea is to put limits as if we wanted to fill the entire play area by 5*5 rooms
+	int lowLimitOfRooms = std::min(this->width / 7, maxRooms); // Entirely arbitrary
+	int highLimitOfRooms = std::min(lowLimitOfRooms * (this->height / 10), maxRooms); // The idea is to put limits as if we wanted to fill the entire play area by 5*5 rooms
 	
-	int numOfRooms = getRandomNumber(lowLimitOfRooms, highLimitOfRooms);
+	RandomStream& placement = rng.get(RNG_STREAM::ROOM_PLACEMENT);
+	int numOfRooms = placement.getNumber(lowLimitOfRooms, highLimitOfRooms);
 
 	std::vector<int> diameters;
 	std::vector<std::array<int, 2>> centers;
@@ -59,48 +64,49 @@ void Level::generateEasyEnvironment() {
 	int yOffset = 1;
 
 	for (int i = 0; i < numOfRooms; ++i) {
-		int newDiameter = getRandomNumber(2, 6); // Trees should be on the shorter side
+		int newDiameter = placement.getNumber(2, 6); // Trees should be on the shorter side
 
 		// Sizes of new rooms
 		diameters.push_back(newDiameter);
 
 		// Centers of new rooms
-		xOffset = (xOffset + (newDiameter*getRandomNumber(2,7))) % PLAY_AREA_WIDTH; // These offsets will serve as room centers
-		yOffset = (yOffset + (newDiameter * getRandomNumber(2, 7))) % PLAY_AREA_HEIGHT;
+		xOffset = (xOffset + (newDiameter*placement.getNumber(2,7))) % this->width; // These offsets will serve as room centers
+		yOffset = (yOffset + (newDiameter * placement.getNumber(2, 7))) % this->height;
 
 		// Prevent rooms going off-bounds, or colliding with exit or spawn rooms
-		while (xOffset < 1 + newDiameter || xOffset + newDiameter >= PLAY_AREA_WIDTH || 
+		while (xOffset < 1 + newDiameter || xOffset + newDiameter >= this->width || 
 			(abs(xOffset-(this->safeRoom->center[0])) < 5+newDiameter) && (abs(yOffset - (this->safeRoom->center[1])) < 5 + newDiameter) ||
 			(abs(xOffset - (this->exitRoom->center[0])) < 5 + newDiameter) && (abs(yOffset - (this->exitRoom->center[1])) < 5 + newDiameter)) { // Make sure we don't go off-bounds
-			xOffset = (xOffset + (newDiameter * getRandomNumber(2, 7))) % PLAY_AREA_WIDTH; // The value is bound to not overlap eventually
+			xOffset = (xOffset + (newDiameter * placement.getNumber(2, 7))) % this->width; // The value is bound to not overlap eventually
 		}
 		// Same as above, but for y coordinate
-		while (yOffset < 1 + newDiameter || yOffset + newDiameter >= PLAY_AREA_HEIGHT ||
+		while (yOffset < 1 + newDiameter || yOffset + newDiameter >= this->height ||
 			(abs(xOffset - (this->safeRoom->center[0])) < 5 + newDiameter) && (abs(yOffset - (this->safeRoom->center[1])) < 5 + newDiameter) ||
 			(abs(xOffset - (this->exitRoom->center[0])) < 5 + newDiameter) && (abs(yOffset - (this->exitRoom->center[1])) < 5 + newDiameter)) { // Make sure we don't go off-bounds
-			yOffset = (yOffset + (newDiameter * getRandomNumber(2, 7))) % PLAY_AREA_WIDTH;
+			yOffset = (yOffset + (newDiameter * placement.getNumber(2, 7))) % this->height;
 		}
 		centers.push_back({ xOffset, yOffset });
 	}
 
 	// Disjoint rooms are meant to emulate trees in a forest. They are just two walls with possible positions for enemies and pickups
 	for (int i = 0; i < diameters.size(); ++i) {
-		this->rooms.push_back(new Room(diameters[i], centers[i][0], centers[i][1], ROOM_TYPE::DISJOINT));
+		this->rooms.push_back(arena.create<Room>(diameters[i], centers[i][0], centers[i][1], ROOM_TYPE::DISJOINT, placement, &arena));
 	}
 	populatePickups();
-	this->pickups.push_back(new Pickup(PICKUP_TYPE::EXIT, this->exitRoom->center));
+	spawnPickup(PICKUP_TYPE::EXIT, this->exitRoom->center);
 	populateEnemies(4, int(ACTOR_TYPE::GOBLIN));
 }
 
 void Level::populatePickups() {
+	RandomStream& pickupRng = rng.get(RNG_STREAM::PICKUPS);
 	for (auto& room : rooms) {
-		if (getRandomNumber(1, 4) == 1) { // Roughly 1/3 rooms should have pickups
+		if (pickupRng.getNumber(1, 4) == 1) { // Roughly 1/3 rooms should have pickups
 			for (auto& coords : room->pickupPositions) {
-				int pickup = getRandomNumber(int(PICKUP_TYPE::DAMAGE), int(PICKUP_TYPE::_count) - 1 );
+				int pickup = pickupRng.getNumber(int(PICKUP_TYPE::DAMAGE), int(PICKUP_TYPE::_count) - 1 );
 				if (pickup == int(PICKUP_TYPE::RANGE)) { // More range is pretty overpowered, so we make it very rare
-					pickup = getRandomNumber(int(PICKUP_TYPE::DAMAGE), int(PICKUP_TYPE::_count) - 1 );
+					pickup = pickupRng.getNumber(int(PICKUP_TYPE::DAMAGE), int(PICKUP_TYPE::_count) - 1 );
 				}
-				this->pickups.push_back(new Pickup(PICKUP_TYPE(pickup), coords));
+				spawnPickup(PICKUP_TYPE(pickup), coords);
 			}
 			
 		}
@@ -108,53 +114,185 @@ void Level::populatePickups() {
 }
 
 void Level::populateEnemies(const int& spawnRate, const int& rangeOfEnemies) {
+	RandomStream& enemyRng = rng.get(RNG_STREAM::ENEMIES);
 	for (auto& room : rooms) {
-		if (getRandomNumber(1, spawnRate) == 1) {
+		if (enemyRng.getNumber(1, spawnRate) == 1) {
 			for (auto& coords : room->actorPositions) {
-				int enemy = getRandomNumber(int(ACTOR_TYPE::GOBLIN), rangeOfEnemies);
-				this->hostileActors.push_back(new Actor(ACTOR_TYPE(enemy), coords));
+				int enemy = enemyRng.getNumber(int(ACTOR_TYPE::GOBLIN), rangeOfEnemies);
+				spawnEnemy(ACTOR_TYPE(enemy), coords);
 			}
 
 		}
 	}
 }
 
-void Level::updateEnemies(Map& map, std::shared_ptr<Player> player, EventSection& events, tcod::Console& console, tcod::ContextPtr& context) {
-	for (auto& enemy : this->hostileActors) {
-		enemy->speed += player->speed;
-		if (enemy->speed + player->speed >= enemy->speedLimit) { // The enemy is allowed to move
-			enemy->speed = enemy->speed % enemy->speedLimit; // Reset the enemy movement
-			if (map.visited[enemy->position[0]][enemy->position[1]] == 2) { // The enemy is in FOV
-				if ((abs(enemy->position[0] - player->position[0]) <= enemy->range) &&
-					(abs(enemy->position[1] - player->position[1]) <= enemy->range)) { // The enemy can reach the player
-					player->health -= enemy->damage / player->armor;
-					events.newEvent(console, context, "A goblin damaged you for " + std::to_string(enemy->damage / player->armor));
-				}
-				else { // Player not in reach, move towards him
-					if ((player->position[0] - enemy->position[0]) > 0 && // Try to align horizontally first
-						!map.isSightBlocker(enemy->position[0] + 1 ,enemy->position[1])) { // Make sure we don't go into a wall
-						map.tiles[enemy->position[0]][enemy->position[1]] = Tileset::floor;
-						enemy->position[0] += 1;
-					}
-					else if ((player->position[0] - enemy->position[0]) < 0 && // Try to align horizontally first
-						!map.isSightBlocker(enemy->position[0] - 1, enemy->position[1])) {
-						map.tiles[enemy->position[0]][enemy->position[1]] = Tileset::floor;
-						enemy->position[0] -= 1;
-					}
-					else { // We need to move vertically
-						if ((player->position[1] - enemy->position[1]) > 0 && // Try to align horizontally first
-							!map.isSightBlocker(enemy->position[0], enemy->position[1] + 1)) { // Make sure we don't go into a wall
-							map.tiles[enemy->position[0]][enemy->position[1]] = Tileset::floor;
-							enemy->position[1] += 1;
-						}
-						else if ((player->position[1] - enemy->position[1]) < 0 && // Try to align horizontally first
-							!map.isSightBlocker(enemy->position[0], enemy->position[1] - 1)) {
-							map.tiles[enemy->position[0]][enemy->position[1]] = Tileset::floor;
-							enemy->position[1] -= 1;
-						}
-					}
-				}
-			}		
+int Level::updateEnemies(Map& map, Player& player, std::vector<GameEvent>& events) {
+	ActorTable& enemies = this->hostileActors;
+	// The player's action took player.speed. Everyone due before the player's next one gets to act
+	int64_t turnStart = this->turns.now();
+	this->turns.advance(player.speed);
+	this->wakeEnemiesInSight(map, player, turnStart);
+	this->dueEnemies.clear();
+	int enemy;
+	while (this->turns.popDue(turnStart, enemy)) {
+		int slot = enemies.slotOf(enemy);
+		if (slot == -1) {
+			continue; // Died since it was filed
+		}
+		if (!this->isDue(slot, turnStart, player.speed)) { // Filed before the player got faster
+			this->turns.schedule(enemy, this->nextDue(slot, this->turns.now(), player.speed));
+			continue;
 		}
+		this->dueEnemies.push_back(slot);
 	}
-}
\ No newline at end of file
+	std::sort(this->dueEnemies.begin(), this->dueEnemies.end()); // Slot order, like when every enemy was checked in turn - runs play out the same
+
+	int moved = 0;
+
+	for (auto& i : this->dueEnemies) {
+		if (!map.visibility.isVisible(enemies.positionX[i], enemies.positionY[i])) { // Out of sight, back to sleep
+			this->awake[enemies.ids[i]] = false;
+			continue;
+		}
+		if ((abs(enemies.positionX[i] - player.position[0]) <= enemies.range[i]) &&
+			(abs(enemies.positionY[i] - player.position[1]) <= enemies.range[i])) { // The enemy can reach the player
+			player.health -= enemies.damage[i] / player.armor;
+			events.push_back({ GAME_EVENT_TYPE::PLAYER_DAMAGED, enemies.damage[i] / player.armor });
+		}
+		else { // Player not in reach, follow the shortest way to him
+			int xChange, yChange;
+			this->pursuit.update(map, player.position[0], player.position[1]); // Only the first chaser of the turn pays for this
+			if (this->pursuit.stepDownhill(map, enemies.positionX[i], enemies.positionY[i], xChange, yChange)) {
+				moveEnemy(map, i, xChange, yChange);
+				++moved;
+			}
+		}
+		this->turns.schedule(enemies.ids[i], this->nextDue(i, this->turns.now(), player.speed));
+	}
+	return moved;
+}
+
+// Vision reaches no further than the sight radius in either direction, so only the buckets around the player can hold anyone in sight
+void Level::wakeEnemiesInSight(const Map& playArea, const Player& player, const int64_t& turnStart) {
+	this->enemyGrid.forEachNear(player.position[0], player.position[1], player.sightRadius, [&](const int& enemy) {
+		int slot = this->hostileActors.slotOf(enemy);
+		if (!this->awake[enemy] && playArea.visibility.isVisible(this->hostileActors.positionX[slot], this->hostileActors.positionY[slot])) {
+			this->awake[enemy] = true;
+			this->turns.schedule(enemy, this->nextDue(slot, turnStart, player.speed));
+		}
+	});
+}
+
+// An enemy acts once its energy, with this action's worth added, would reach its limit with one more added on top
+// While the player's speed is at least half the enemy's limit that always holds, and the enemy acts after every player action
+bool Level::isDue(const int& slot, const int64_t& turnStart, const int& playerSpeed) const {
+	return this->hostileActors.energyAt(slot, turnStart) + 2 * playerSpeed >= this->hostileActors.speedLimit[slot];
+}
+
+// The earliest time from then on that isDue() holds - the player only ever gets faster, so this is never too late
+int64_t Level::nextDue(const int& slot, const int64_t& from, const int& playerSpeed) const {
+	int missing = this->hostileActors.speedLimit[slot] - 2 * playerSpeed - this->hostileActors.energyAt(slot, from);
+	return from + std::max(0, missing);
+}
+
+// Reading order - top to bottom, then left to right
+static bool isBefore(const int& x, const int& y, const int& otherX, const int& otherY) {
+	return y < otherY || (y == otherY && x < otherX);
+}
+
+int Level::nearestVisibleEnemy(const Map& playArea, const int& x, const int& y, const int& range) const {
+	const ActorTable& enemies = this->hostileActors;
+	int nearest = -1;
+	int nearestSlot = -1;
+	int nearestDistance = 0;
+	this->enemyGrid.forEachNear(x, y, range, [&](const int& enemy) {
+		int slot = enemies.slotOf(enemy);
+		int xDistance = enemies.positionX[slot] - x;
+		int yDistance = enemies.positionY[slot] - y;
+		if (abs(xDistance) > range || abs(yDistance) > range || !playArea.visibility.isVisible(enemies.positionX[slot], enemies.positionY[slot])) {
+			return; // The bucket reaches further than we do, or the enemy is out of sight
+		}
+		int distance = xDistance * xDistance + yDistance * yDistance;
+		// Ties go to the topmost, then leftmost - bucket order depends on the history of moves, and a restored game has none
+		// Enemies spawned from overlapping rooms can share a cell, those go by slot - a restored game keeps the slot order
+		bool tied = nearest != -1 && enemies.positionX[slot] == enemies.positionX[nearestSlot] && enemies.positionY[slot] == enemies.positionY[nearestSlot];
+		if (nearest == -1 || distance < nearestDistance || (distance == nearestDistance && isBefore(enemies.positionX[slot], enemies.positionY[slot],
+			enemies.positionX[nearestSlot], enemies.positionY[nearestSlot])) || (tied && slot < nearestSlot)) {
+			nearest = enemy;
+			nearestSlot = slot;
+			nearestDistance = distance;
+		}
+	});
+	return nearest;
+}
+
+Pickup* Level::nearestVisiblePickup(const Map& playArea, const int& x, const int& y, const int& range) const {
+	Pickup* nearest = nullptr;
+	int nearestDistance = 0;
+	this->pickupGrid.forEachNear(x, y, range, [&](Pickup* pickup) {
+		int xDistance = pickup->position[0] - x;
+		int yDistance = pickup->position[1] - y;
+		if (abs(xDistance) > range || abs(yDistance) > range || !playArea.visibility.isVisible(pickup->position[0], pickup->position[1])) {
+			return;
+		}
+		int distance = xDistance * xDistance + yDistance * yDistance;
+		// Pickups sharing a cell go by type - which of two alike is taken makes no difference
+		bool tied = nearest != nullptr && pickup->position == nearest->position;
+		if (nearest == nullptr || distance < nearestDistance || (distance == nearestDistance && isBefore(pickup->position[0], pickup->position[1], nearest->position[0], nearest->position[1])) ||
+			(tied && int(pickup->type) < int(nearest->type))) {
+			nearest = pickup;
+			nearestDistance = distance;
+		}
+	});
+	return nearest;
+}
+
+void Level::killEnemy(Map& playArea, const int& enemy) {
+	int slot = this->hostileActors.slotOf(enemy);
+	playArea.setTile(this->hostileActors.positionX[slot], this->hostileActors.positionY[slot], Tileset::floor);
+	this->enemyGrid.remove(enemy, this->hostileActors.positionX[slot], this->hostileActors.positionY[slot]);
+	this->hostileActors.remove(enemy);
+}
+
+int Level::spawnEnemy(const ACTOR_TYPE& type, const std::array<int, 2>& position) {
+	return spawnEnemy(Actor(type, position));
+}
+
+int Level::spawnEnemy(const Actor& enemy) {
+	int spawned = this->hostileActors.add(enemy, this->turns.now());
+	this->enemyGrid.insert(spawned, enemy.position[0], enemy.position[1]);
+	this->awake.resize(spawned + 1, false); // Asleep until it is seen
+	return spawned;
+}
+
+void Level::spawnPickup(const PICKUP_TYPE& type, const std::array<int, 2>& position) {
+	Pickup* pickup = arena.create<Pickup>(type, position);
+	this->pickups.push_back(pickup);
+	this->pickupGrid.insert(pickup, position[0], position[1]);
+}
+
+void Level::removePickup(Map& playArea, Pickup* pickup) {
+	playArea.setTile(pickup->position[0], pickup->position[1], Tileset::floor);
+	this->pickupGrid.remove(pickup, pickup->position[0], pickup->position[1]);
+	auto found = std::find(this->pickups.begin(), this->pickups.end(), pickup);
+	*found = this->pickups.back();
+	this->pickups.pop_back();
+}
+
+void Level::moveEnemy(Map& playArea, const int& slot, const int& xChange, const int& yChange) {
+	int& x = this->hostileActors.positionX[slot];
+	int& y = this->hostileActors.positionY[slot];
+	playArea.setTile(x, y, Tileset::floor); // drawEnemies puts it back at the new spot
+	this->enemyGrid.move(this->hostileActors.ids[slot], x, y, x + xChange, y + yChange);
+	x += xChange;
+	y += yChange;
+}
+
+void Level::clearEntities() {
+	this->pickups.clear(); // The pickups themselves stay in the arena until the floor is gone
+	this->pickupGrid.clear();
+	this->hostileActors.clear();
+	this->enemyGrid.clear();
+	this->turns.clear(); // Ids start over
+	this->awake.clear();
+}
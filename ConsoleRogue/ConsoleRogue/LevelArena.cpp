@@ -0,0 +1,30 @@
+#include "GameCore.h"
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+
+LevelArena::LevelArena(const size_t& blockSize) : blockSize(blockSize), current(nullptr), remaining(0), used(0), reserved(0) {}
+
+LevelArena::~LevelArena() {
+	for (auto& block : this->blocks) {
+		::operator delete(block);
+	}
+}
+
+void* LevelArena::do_allocate(size_t bytes, size_t alignment) {
+	size_t padding = (alignment - (reinterpret_cast<uintptr_t>(this->current) % alignment)) % alignment;
+	if (this->current == nullptr || padding + bytes > this->remaining) {
+		// Start a new block - oversized requests simply get a block of their own
+		size_t size = std::max(this->blockSize, bytes + alignment);
+		this->current = static_cast<char*>(::operator new(size));
+		this->blocks.push_back(this->current);
+		this->remaining = size;
+		this->reserved += size;
+		padding = (alignment - (reinterpret_cast<uintptr_t>(this->current) % alignment)) % alignment;
+	}
+	char* allocation = this->current + padding;
+	this->current += padding + bytes;
+	this->remaining -= padding + bytes;
+	this->used += bytes;
+	return allocation;
+}
@@ -1,145 +1,103 @@
-#include "GameState.h"
-#include "libtcod.hpp"
-#include "SDL.h"
+#include "GameCore.h"
 #include <string>
 #include <ctype.h>
 #include <stdio.h>
-// SDL defines main and causes errors
-#undef main
+#include <algorithm>
 
 using namespace std;
 
-Map::Map(const std::shared_ptr<Palette> palette) : palette(palette), level(new Level(palette->inSightWoodWall,
-	palette->outOfSightWoodWall, palette->inSightGrassFloor, palette->outOfSightGrassFloor, palette->outOfSightPickup, palette->inSightPickup, 1)) // The last argument always instantiates level 1 environment
+Map::Map(const uint64_t& runSeed, const int& width, const int& height, FLOOR_GENERATION floorGeneration) : tiles(Tileset::floor), runSeed(runSeed), level(nullptr), floorGeneration(floorGeneration), dirty(false)
 {
-	sightBlockers = { Tileset::wall, Tileset::armorPickup, Tileset::damagePickup, Tileset::exit, Tileset::healthRefillPickup,
-		Tileset::healthUpgradePickup, Tileset::rangePickup, Tileset::speedPickup, Tileset::goblin };
+	setSize(width, height);
+	this->level = new Level(1, RandomService::deriveSeed(runSeed, 1), this->width, this->height); // Level 1 environment is always instantiated first
+	terrainVersion = 0;
+	prefetchLevel(2);
+	wholeMapDirty = true;
 }
 
-void Map::setupNewPlayArea(Player& player, tcod::Console& console, tcod::ContextPtr& context) {
-	// Set up play area borders
-	for (int i = 0; i < PLAY_AREA_HEIGHT; ++i) {
-		this->visited[0][i] = 0;
-		this->visited[PLAY_AREA_WIDTH -1][i] = 0;
-		this->tiles[0][i] = Tileset::wall;
-		this->tiles[PLAY_AREA_WIDTH - 1][i] = Tileset::wall;
-	}
-	for (int i = 0; i < PLAY_AREA_WIDTH; ++i) {
-		this->visited[i][0] = 0;
-		this->visited[i][PLAY_AREA_HEIGHT - 1] = 0;
-		this->tiles[i][0] = Tileset::wall;
-		this->tiles[i][PLAY_AREA_HEIGHT - 1] = Tileset::wall;
-	}
-	// Fill the map with floor
-	for (int i = 1; i < PLAY_AREA_WIDTH - 1; ++i) {
-		for (int j = 1; j < PLAY_AREA_HEIGHT - 1; ++j) {
-			this->visited[i][j] = 0;
-			this->tiles[i][j] = Tileset::floor;
-		}
+Map::~Map() {
+	delete this->level;
+	if (this->nextLevel.valid()) {
+		delete this->nextLevel.get(); // Waits for the worker, if it is still busy
 	}
+}
+
+void Map::setSize(const int& width, const int& height) {
+	this->width = std::clamp(width, MIN_MAP_SIZE, MAX_MAP_SIZE);
+	this->height = std::clamp(height, MIN_MAP_SIZE, MAX_MAP_SIZE);
+	this->tiles.reset(this->width, this->height);
+	this->visibility.reset(this->width, this->height);
+	this->dirty.reset(this->width, this->height);
+	this->dirtyCells.clear();
+	this->wholeMapDirty = true;
+}
+
+void Map::setupNewPlayArea(Player& player) {
+	this->visibility.reset(this->width, this->height);
+	// Empty cells are floor and the edge is wall by itself, so a fresh floor starts with nothing stored
+	this->tiles.reset(this->width, this->height);
+	markAllDirty(); // Cheaper than tracking every cell we just overwrote
+	++this->terrainVersion;
 	player.placeSelf(*this, this->level->safeRoom->center[0], this->level->safeRoom->center[1]);
 	this->drawRooms();
 	this->drawPickups();
 	this->drawEnemies();
-	drawWholeMap(console, context);
 	return;
 }
 
-void Map::drawWholeMap(tcod::Console& console, tcod::ContextPtr& context) {
-	this->drawEnemies();
-	for (int i = 0; i < PLAY_AREA_WIDTH; ++i) {
-		for (int j = 0; j < PLAY_AREA_HEIGHT; ++j) {
-			this->setSingleTile(console, i, j);
-		}
-	}	
-	context->present(console);
+void Map::resetActiveSight() {
+	this->visibility.resetVisible([this](const int& x, const int& y) { markDirty(x, y); });
 }
 
-void Map::setSingleTile(tcod::Console& console, const int& x, const int& y) {
-	std::string toPrint = "";
-	toPrint += tiles[x][y];
-	
-	// The differentiation is necesarry for differences in behavior for tile in active FOV
-	switch (this->tiles[x][y]) {
-	case Tileset::wall:
-		if (this->visited[x][y] == 2) {	
-			// Hours wasted counter: 10
-			// This hard-coded color simply HAS to be here
-			// May god have mercy on the fool who dares remove it and catch the bug that will surely follow
-			tcod::print(console, { x,y }, toPrint, tcod::ColorRGB(102, 51, 0), std::nullopt);
+void Map::generateNewLevel(const int& difficultyLevel) {
+	// The old floor goes away with its arena
+	delete this->level;
+	this->level = nullptr;
+	if (this->nextLevel.valid()) {
+		Level* prefetched = this->nextLevel.get(); // Normally long finished by the time the player finds the exit
+		if (prefetched->difficultyLevel == difficultyLevel && prefetched->rng.getSeed() == RandomService::deriveSeed(this->runSeed, difficultyLevel) &&
+			prefetched->width == this->width && prefetched->height == this->height) {
+			this->level = prefetched;
+		}
+		else {
+			delete prefetched;
 		}
-		else if (this->visited[x][y] == 1) { tcod::print(console, { x,y }, toPrint, level->outOfSightWall, std::nullopt); }
-		break;
-	case Tileset::floor:
-		if (this->visited[x][y] == 2) { tcod::print(console, { x,y }, toPrint, level->inSightFloor, std::nullopt); }
-		else if (this->visited[x][y] == 1) { tcod::print(console, { x,y }, toPrint, level->outOfSightFloor, std::nullopt); }
-		break;
-	case Tileset::player:
-		tcod::print(console, { x,y }, toPrint, palette->playerCharacter, std::nullopt);
-		break;
-	case Tileset::goblin:
-		if (this->visited[x][y] == 2) { tcod::print(console, { x,y }, toPrint, palette->goblin, std::nullopt); }
-		else if (this->visited[x][y] == 1) { tcod::print(console, { x,y }, std::string(1,Tileset::floor), level->outOfSightFloor, std::nullopt); }
-		break;
-	default: // Pickups
-		if (this->visited[x][y] == 2) { tcod::print(console, { x,y }, toPrint, level->inSightPickup, std::nullopt); }
-		else if (this->visited[x][y] == 1) { tcod::print(console, { x,y }, toPrint, level->outOfSightPickup, std::nullopt); }
-		break;
-	}
-}
-
-bool Map::isSightBlocker(const int& x, const int& y) {
-	if (x < 0 || x > PLAY_AREA_WIDTH - 1 || y < 0 || y > PLAY_AREA_HEIGHT - 1) {
-		return true;
 	}
-	else if (std::find(this->sightBlockers.begin(), this->sightBlockers.end(), this->tiles[x][y]) != this->sightBlockers.end()) {
-		return true;
+	if (this->level == nullptr) { // Nothing prefetched for this floor (or run - a loaded game swaps the run seed and size), so it is built on the spot - it comes out the same either way
+		this->level = new Level(difficultyLevel, RandomService::deriveSeed(this->runSeed, difficultyLevel), this->width, this->height);
 	}
-	return false;
+	prefetchLevel(difficultyLevel + 1);
 }
 
-void Map::resetActiveSight() {
-	for (int i = 0; i < PLAY_AREA_WIDTH; ++i) {
-		for (int j = 0; j < PLAY_AREA_HEIGHT; ++j) {
-			if (this->visited[i][j] == 2) { this->visited[i][j] = 1; };
-		}
-	}
-}
-
-void Map::generateNewLevel(const int& difficultyLevel) {
-	// We call the level constructor again
-	if (difficultyLevel < 3) {
-		this->level = new Level(palette->inSightWoodWall,
-			palette->outOfSightWoodWall, palette->inSightGrassFloor, palette->outOfSightGrassFloor, palette->outOfSightPickup, palette->inSightPickup, difficultyLevel);
-	}
-	else if (difficultyLevel > 2 && difficultyLevel < 6) {
-		this->level = new Level(palette->inSightWoodWall,
-			palette->outOfSightWoodWall, palette->inSightGrassFloor, palette->outOfSightGrassFloor, palette->outOfSightPickup, palette->inSightPickup, difficultyLevel);
-	}
-	else if (difficultyLevel > 5) {
-		this->level = new Level(palette->inSightWoodWall,
-			palette->outOfSightWoodWall, palette->inSightGrassFloor, palette->outOfSightGrassFloor, palette->outOfSightPickup, palette->inSightPickup, difficultyLevel);
-	}
+void Map::prefetchLevel(const int& difficultyLevel) {
+	if (this->floorGeneration == FLOOR_GENERATION::ON_CALLING_THREAD) {
+		return; // generateNewLevel() builds it when it is needed
+	}
+	uint64_t seed = RandomService::deriveSeed(this->runSeed, difficultyLevel);
+	// A Level only touches its own arena and random streams, so it can be built off the main thread
+	int width = this->width;
+	int height = this->height;
+	this->nextLevel = std::async(std::launch::async, [difficultyLevel, seed, width, height]() { return new Level(difficultyLevel, seed, width, height); });
 }
 
 void Map::drawRooms() {
 	for (auto &coord : this->level->safeRoom->wallPositions) {
-		this->tiles[coord[0]][coord[1]] = Tileset::wall;
+		setTile(coord[0], coord[1], Tileset::wall);
 	}
 	for (auto& coord : this->level->exitRoom->wallPositions) {
-		this->tiles[coord[0]][coord[1]] = Tileset::wall;
+		setTile(coord[0], coord[1], Tileset::wall);
 	}
 	for (auto& room : this->level->rooms) {
 		for (auto& coord : room->wallPositions) {
-			this->tiles[coord[0]][coord[1]] = Tileset::wall;
+			setTile(coord[0], coord[1], Tileset::wall);
 		}
 	}
 	for (auto& room : this->level->corridors) {
 		for (auto& coord : room->wallPositions) {
-			this->tiles[coord[0]][coord[1]] = Tileset::wall;
+			setTile(coord[0], coord[1], Tileset::wall);
 		}
 		for (auto& coord : room->floorPositions) {
-			this->tiles[coord[0]][coord[1]] = Tileset::floor;
+			setTile(coord[0], coord[1], Tileset::floor);
 		}
 	}
 }
@@ -148,38 +106,79 @@ void Map::drawPickups() {
 	for (auto& pickup : this->level->pickups) {
 		switch (pickup->type) {
 		case PICKUP_TYPE::EXIT:
-			tiles[pickup->position[0]][pickup->position[1]] = Tileset::exit;
+			setTile(pickup->position[0], pickup->position[1], Tileset::exit);
 			break;
 		case PICKUP_TYPE::ARMOR:
-			tiles[pickup->position[0]][pickup->position[1]] = Tileset::armorPickup;
+			setTile(pickup->position[0], pickup->position[1], Tileset::armorPickup);
 			break;
 		case PICKUP_TYPE::DAMAGE:
-			tiles[pickup->position[0]][pickup->position[1]] = Tileset::damagePickup;
+			setTile(pickup->position[0], pickup->position[1], Tileset::damagePickup);
 			break;
 		case PICKUP_TYPE::HEALTH_REFILL:
-			tiles[pickup->position[0]][pickup->position[1]] = Tileset::healthRefillPickup;
+			setTile(pickup->position[0], pickup->position[1], Tileset::healthRefillPickup);
 			break;
 		case PICKUP_TYPE::HEALTH_UPGRADE:
-			tiles[pickup->position[0]][pickup->position[1]] = Tileset::healthUpgradePickup;
+			setTile(pickup->position[0], pickup->position[1], Tileset::healthUpgradePickup);
 			break;
 		case PICKUP_TYPE::RANGE:
-			tiles[pickup->position[0]][pickup->position[1]] = Tileset::rangePickup;
+			setTile(pickup->position[0], pickup->position[1], Tileset::rangePickup);
 			break;
 		case PICKUP_TYPE::SPEED:
-			tiles[pickup->position[0]][pickup->position[1]] = Tileset::speedPickup;
+			setTile(pickup->position[0], pickup->position[1], Tileset::speedPickup);
+			break;
+		default: // _count only sizes tables, no pickup has it
 			break;
 		}
 	}
 }
 
 void Map::drawEnemies() {
-	for (auto& actor : this->level->hostileActors) {
-		switch (actor->type) {
+	const ActorTable& enemies = this->level->hostileActors;
+	for (int i = 0; i < enemies.size(); ++i) {
+		switch (enemies.type[i]) {
 		case ACTOR_TYPE::GOBLIN:
-			tiles[actor->position[0]][actor->position[1]] = Tileset::goblin;
+			setTile(enemies.positionX[i], enemies.positionY[i], Tileset::goblin);
 			break;
 		default:
 			break;
 		}
 	}
+}
+
+void Map::setTile(const int& x, const int& y, const char& tile) {
+	if (x <= 0 || x >= this->width - 1 || y <= 0 || y >= this->height - 1) {
+		return;
+	}
+	if (this->tiles.get(x, y) != tile) {
+		if (isTerrainBlocker(x, y) != (TileProperties::has(tile, TileProperties::blocksMovement) && !TileProperties::has(tile, TileProperties::isActor))) {
+			++this->terrainVersion;
+		}
+		this->tiles.set(x, y, tile);
+		markDirty(x, y);
+	}
+}
+
+void Map::setVisible(const int& x, const int& y) {
+	if (this->visibility.setVisible(x, y)) {
+		markDirty(x, y);
+	}
+}
+
+void Map::markDirty(const int& x, const int& y) {
+	if (!this->dirty.get(x, y)) { // Reading doesn't allocate, and most cells asked about are dirty already
+		this->dirty.set(x, y, true);
+		this->dirtyCells.push_back({ x, y });
+	}
+}
+
+void Map::markAllDirty() {
+	this->wholeMapDirty = true;
+}
+
+void Map::clearDirty() {
+	for (auto& cell : this->dirtyCells) {
+		this->dirty.set(cell[0], cell[1], false);
+	}
+	this->dirtyCells.clear();
+	this->wholeMapDirty = false;
 }
\ No newline at end of file
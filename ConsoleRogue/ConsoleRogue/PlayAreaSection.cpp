@@ -0,0 +1,137 @@
+#include "GameState.h"
+#include "libtcod.hpp"
+#include "SDL.h"
+
+PlayAreaSection::PlayAreaSection(const std::shared_ptr<Palette> palette) : palette(palette), terrainDrawn(false), terrainLeft(0), terrainTop(0) {
+	this->buildLooks();
+	for (auto& layer : this->terrainLayers) {
+		layer = tcod::Console{ this->camera.width, this->camera.height };
+	}
+}
+
+void PlayAreaSection::drawWholeMap(tcod::Console& console, Map& playArea, const Player& player) {
+	this->camera.centreOn(playArea.width, playArea.height, player.position[0], player.position[1]);
+	this->drawView(console, playArea, player);
+}
+
+void PlayAreaSection::drawChangedTiles(tcod::Console& console, Map& playArea, const Player& player) {
+	bool scrolled = this->camera.follow(playArea.width, playArea.height, player.position[0], player.position[1]);
+	if (scrolled || playArea.wholeMapDirty) {
+		this->drawView(console, playArea, player);
+		return;
+	}
+	for (auto& cell : playArea.dirtyCells) {
+		if (this->camera.contains(cell[0], cell[1])) { // Whatever changed out of view gets drawn once the camera gets there
+			this->setSingleTile(console, playArea, cell[0], cell[1]);
+		}
+	}
+	playArea.clearDirty();
+}
+
+// Only the cells under the camera are looked at, so this costs the same however big the map is
+// Terrain comes from the cached layers by visibility alone, then the few things that move or go away are drawn over it
+void PlayAreaSection::drawView(tcod::Console& console, Map& playArea, const Player& player) {
+	if (playArea.wholeMapDirty || !this->terrainDrawn || this->terrainLeft != this->camera.left || this->terrainTop != this->camera.top) {
+		this->drawTerrain(playArea);
+	}
+	const TCOD_ConsoleTile& blank = this->looks[0]; // Off the edge of a map smaller than the view
+	int right = std::min(this->camera.width, playArea.width - this->camera.left);
+	int bottom = std::min(this->camera.height, playArea.height - this->camera.top);
+	const int chunkSize = VisibilityPlanes::chunkSize;
+	for (int row = 0; row < this->camera.height; ++row) {
+		TCOD_ConsoleTile* tiles = console.begin() + row * console.get_width();
+		int y = this->camera.top + row;
+		int first = row * this->camera.width;
+		int column = 0;
+		while (row < bottom && column < right) { // A chunk row at a time, its visibility read as two masks
+			int x = this->camera.left + column;
+			int chunk = playArea.visibility.chunkOf(x, y);
+			uint32_t visible = playArea.visibility.visibleMask(chunk, y & (chunkSize - 1));
+			uint32_t known = visible | playArea.visibility.seenMask(chunk, y & (chunkSize - 1));
+			int end = std::min(right, column + chunkSize - (x & (chunkSize - 1)));
+			if (known == 0) { // Never seen, the whole span is blank
+				std::fill(tiles + column, tiles + end, blank);
+				column = end;
+				continue;
+			}
+			for (; column < end; ++column) {
+				int bit = (this->camera.left + column) & (chunkSize - 1);
+				int state = int((visible >> bit) & 1u) + int((known >> bit) & 1u); // Whatever is visible is known too, so this is stateOf()
+				tiles[column] = this->terrainLayers[state].begin()[first + column];
+			}
+		}
+		std::fill(tiles + column, tiles + this->camera.width, blank);
+	}
+
+	// The glyph on the map is what decides the look, the Level only says where to look
+	auto drawOver = [&](const int& x, const int& y) {
+		if (this->camera.contains(x, y)) {
+			this->setSingleTile(console, playArea, x, y);
+		}
+	};
+	const Level& level = *playArea.level;
+	int centreX = this->camera.left + this->camera.width / 2;
+	int centreY = this->camera.top + this->camera.height / 2;
+	int reach = std::max(this->camera.width, this->camera.height) / 2 + 1;
+	level.pickupGrid.forEachNear(centreX, centreY, reach, [&](Pickup* pickup) { drawOver(pickup->position[0], pickup->position[1]); });
+	level.enemyGrid.forEachNear(centreX, centreY, reach, [&](const int& enemy) {
+		int slot = level.hostileActors.slotOf(enemy);
+		drawOver(level.hostileActors.positionX[slot], level.hostileActors.positionY[slot]);
+	});
+	drawOver(player.position[0], player.position[1]);
+	playArea.clearDirty();
+}
+
+void PlayAreaSection::drawTerrain(Map& playArea) {
+	const TCOD_ConsoleTile& blank = this->looks[0];
+	for (int row = 0; row < this->camera.height; ++row) {
+		for (int column = 0; column < this->camera.width; ++column) {
+			int x = this->camera.left + column;
+			int y = this->camera.top + row;
+			int index = row * this->camera.width + column;
+			if (!playArea.isOnMap(x, y)) {
+				for (auto& layer : this->terrainLayers) {
+					layer.begin()[index] = blank;
+				}
+				continue;
+			}
+			char terrain = playArea.tileAt(x, y);
+			if (TileProperties::has(terrain, TileProperties::isActor | TileProperties::isPickup)) {
+				terrain = Tileset::floor; // Whatever stands there is drawn over it
+			}
+			for (int state = 0; state < 3; ++state) {
+				this->terrainLayers[state].begin()[index] = this->looks[(unsigned char)terrain * 3 + state];
+			}
+		}
+	}
+	this->terrainDrawn = true;
+	this->terrainLeft = this->camera.left;
+	this->terrainTop = this->camera.top;
+}
+
+void PlayAreaSection::setSingleTile(tcod::Console& console, Map& playArea, const int& x, const int& y) {
+	console[{ this->camera.screenX(x), this->camera.screenY(y) }] = this->lookOf(playArea, x, y);
+}
+
+void PlayAreaSection::buildLooks() {
+	auto look = [&](const char& glyph, const tcod::ColorRGB& color) {
+		return TCOD_ConsoleTile{ (unsigned char)glyph, tcod::ColorRGBA(color), tcod::ColorRGBA(this->palette->playAreaBackground) };
+	};
+	TCOD_ConsoleTile blank = look(' ', this->palette->playAreaBackground);
+	for (int glyph = 0; glyph < 256; ++glyph) { // Anything without a look of its own is a pickup
+		this->looks[glyph * 3] = blank;
+		this->looks[glyph * 3 + 1] = look(char(glyph), this->palette->outOfSightPickup);
+		this->looks[glyph * 3 + 2] = look(char(glyph), this->palette->inSightPickup);
+	}
+	auto setLooks = [&](const char& glyph, const TCOD_ConsoleTile& seen, const TCOD_ConsoleTile& inSight) {
+		this->looks[(unsigned char)glyph * 3 + 1] = seen;
+		this->looks[(unsigned char)glyph * 3 + 2] = inSight;
+	};
+	setLooks(Tileset::wall, look(Tileset::wall, this->palette->outOfSightWoodWall), look(Tileset::wall, this->palette->inSightWoodWall));
+	setLooks(Tileset::floor, look(Tileset::floor, this->palette->outOfSightGrassFloor), look(Tileset::floor, this->palette->inSightGrassFloor));
+	// Goblins out of sight are remembered as the floor they stood on
+	setLooks(Tileset::goblin, look(Tileset::floor, this->palette->outOfSightGrassFloor), look(Tileset::goblin, this->palette->goblin));
+	for (int state = 0; state < 3; ++state) { // The player is always drawn, whatever the vision says
+		this->looks[(unsigned char)Tileset::player * 3 + state] = look(Tileset::player, this->palette->playerCharacter);
+	}
+}
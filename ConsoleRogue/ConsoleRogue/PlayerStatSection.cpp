@@ -2,27 +2,57 @@
 #include "libtcod.hpp"
 #include "SDL.h"
 #include <string>
+#include <cstdio>
 
-void PlayerStatSection::colorArea(tcod::Console& console, tcod::ContextPtr& context) {
-	tcod::draw_rect(console, { PLAY_AREA_WIDTH, 0, STAT_AREA_WIDTH, STAT_AREA_HEIGHT }, ' ', std::nullopt, this->palette->statBackground);
-	context->present(console);
+void PlayerStatSection::draw(tcod::Console& console, const bool& force) {
+	std::array<int, 6> stats = this->currentStats();
+	bool changed = !this->panelDrawn || stats != this->shownStats;
+	if (changed) {
+		this->shownStats = stats;
+		this->drawPanel();
+		this->panelDrawn = true;
+	}
+	if (changed || force) {
+		tcod::blit(console, this->panel, { PLAY_AREA_WIDTH, 0 });
+	}
 }
 
-void PlayerStatSection::drawTextFields(tcod::Console& console, tcod::ContextPtr& context) {
-	tcod::print(console, { PLAY_AREA_WIDTH + 1,  2 }, "PLAYER STATS", this->palette->statHeaders, this->palette->statBackground);
-	tcod::print(console, { PLAY_AREA_WIDTH + 1,  6 }, "Health: ", this->palette->statHeaders, this->palette->statBackground);
-	tcod::print(console, { PLAY_AREA_WIDTH + 1,  8 }, "Damage: ", this->palette->statHeaders, this->palette->statBackground);
-	tcod::print(console, { PLAY_AREA_WIDTH + 1,  10 }, " Speed: ", this->palette->statHeaders, this->palette->statBackground);
-	tcod::print(console, { PLAY_AREA_WIDTH + 1,  12 }, " Armor: ", this->palette->statHeaders, this->palette->statBackground);
-	tcod::print(console, { PLAY_AREA_WIDTH + 1,  14 }, " Range: ", this->palette->statHeaders, this->palette->statBackground);
-	context->present(console);
+std::array<int, 6> PlayerStatSection::currentStats() const {
+	return { this->player->health, this->player->maxHealth, this->player->damage, 100 - this->player->speed, this->player->armor, this->player->range };
 }
 
-void PlayerStatSection::drawStatValues(tcod::Console& console, tcod::ContextPtr& context) {
-	tcod::print(console, { PLAY_AREA_WIDTH + 9,  6 }, std::to_string(this->player->health) + "/" + std::to_string(this->player->maxHealth), this->palette->statHeaders, this->palette->statBackground);
-	tcod::print(console, { PLAY_AREA_WIDTH + 9,  8 }, std::to_string(this->player->damage), this->palette->statHeaders, this->palette->statBackground);
-	tcod::print(console, { PLAY_AREA_WIDTH + 9,  10 }, std::to_string(100-this->player->speed), this->palette->statHeaders, this->palette->statBackground);
-	tcod::print(console, { PLAY_AREA_WIDTH + 9,  12 }, std::to_string(this->player->armor), this->palette->statHeaders, this->palette->statBackground);
-	tcod::print(console, { PLAY_AREA_WIDTH + 9,  14 }, std::to_string(this->player->range), this->palette->statHeaders, this->palette->statBackground);
-	context->present(console);
-}
\ No newline at end of file
+void PlayerStatSection::drawPanel() {
+	tcod::draw_rect(this->panel, { 0, 0, STAT_AREA_WIDTH, STAT_AREA_HEIGHT }, ' ', std::nullopt, this->palette->statBackground);
+	tcod::print(this->panel, { 1,  2 }, "PLAYER STATS", this->palette->statHeaders, this->palette->statBackground);
+	tcod::print(this->panel, { 1,  6 }, "Health: ", this->palette->statHeaders, this->palette->statBackground);
+	tcod::print(this->panel, { 1,  8 }, "Damage: ", this->palette->statHeaders, this->palette->statBackground);
+	tcod::print(this->panel, { 1,  10 }, " Speed: ", this->palette->statHeaders, this->palette->statBackground);
+	tcod::print(this->panel, { 1,  12 }, " Armor: ", this->palette->statHeaders, this->palette->statBackground);
+	tcod::print(this->panel, { 1,  14 }, " Range: ", this->palette->statHeaders, this->palette->statBackground);
+
+	tcod::print(this->panel, { 9,  6 }, std::to_string(this->shownStats[0]) + "/" + std::to_string(this->shownStats[1]), this->palette->statHeaders, this->palette->statBackground);
+	for (int i = 2; i < 6; ++i) {
+		tcod::print(this->panel, { 9,  6 + (i - 1) * 2 }, std::to_string(this->shownStats[i]), this->palette->statHeaders, this->palette->statBackground);
+	}
+}
+
+void PlayerStatSection::drawProfilerOverlay(tcod::Console& console, const TurnProfiler& profiler, const int& presentsPerTurn, const Level& level) {
+	const char* phaseNames[int(TURN_PHASE::_count)] = { "Input", "Movement", "Enemies", "Vision", "Drawing", "Present" };
+	int y = STAT_AREA_HEIGHT - 14;
+	char line[STAT_AREA_WIDTH];
+	snprintf(line, sizeof(line), "%-12s%10s%10s", "TURN (us)", "last", "p99");
+	tcod::print(console, { PLAY_AREA_WIDTH + 1,  y }, line, this->palette->statHeaders, this->palette->statBackground);
+	for (int phase = 0; phase < int(TURN_PHASE::_count); ++phase) {
+		// Padded to a fixed width, so a shorter number overwrites a longer one
+		snprintf(line, sizeof(line), "%-12s%10.1f%10.1f", phaseNames[phase], profiler.last(TURN_PHASE(phase)) / 1000.0, profiler.percentile99(TURN_PHASE(phase)) / 1000.0);
+		tcod::print(console, { PLAY_AREA_WIDTH + 1,  y + 2 + phase }, line, this->palette->statHeaders, this->palette->statBackground);
+	}
+	snprintf(line, sizeof(line), "%-22s%10d", "Enemies", level.hostileActors.size());
+	tcod::print(console, { PLAY_AREA_WIDTH + 1,  STAT_AREA_HEIGHT - 5 }, line, this->palette->statHeaders, this->palette->statBackground);
+	snprintf(line, sizeof(line), "%-22s%10d", "Pickups", int(level.pickups.size()));
+	tcod::print(console, { PLAY_AREA_WIDTH + 1,  STAT_AREA_HEIGHT - 4 }, line, this->palette->statHeaders, this->palette->statBackground);
+	snprintf(line, sizeof(line), "%-22s%10d", "Presents/turn", presentsPerTurn);
+	tcod::print(console, { PLAY_AREA_WIDTH + 1,  STAT_AREA_HEIGHT - 3 }, line, this->palette->statHeaders, this->palette->statBackground);
+	snprintf(line, sizeof(line), "%-22s%7d KB", "Level memory", int(level.arena.bytesUsed() / 1024));
+	tcod::print(console, { PLAY_AREA_WIDTH + 1,  STAT_AREA_HEIGHT - 2 }, line, this->palette->statHeaders, this->palette->statBackground);
+}
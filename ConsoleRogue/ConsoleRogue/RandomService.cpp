@@ -0,0 +1,64 @@
+#include "GameCore.h"
+#include <random>
+
+// SplitMix64 - used only to spread seeds, so neighbouring keys don't give correlated streams
+static uint64_t splitMix(uint64_t value) {
+	value += 0x9E3779B97F4A7C15ull;
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
+RandomStream::RandomStream(uint64_t seed, uint64_t streamId) : state(0) {
+	increment = (streamId << 1u) | 1u; // PCG needs an odd increment
+	next();
+	state += seed;
+	next();
+}
+
+uint32_t RandomStream::next() {
+	uint64_t oldState = state;
+	state = oldState * 6364136223846793005ull + increment;
+	uint32_t xorShifted = uint32_t(((oldState >> 18u) ^ oldState) >> 27u);
+	uint32_t rotation = uint32_t(oldState >> 59u);
+	return (xorShifted >> rotation) | (xorShifted << ((~rotation + 1u) & 31u));
+}
+
+int RandomStream::getNumber(const int& from, const int& to) {
+	int low = from;
+	int high = to;
+	if (from > to) { // Preventing headaches from misordered parameters
+		low = to;
+		high = from;
+	}
+	uint32_t range = uint32_t(int64_t(high) - int64_t(low)) + 1u;
+	if (range == 0) { // The whole 32 bit range was requested
+		return int(next());
+	}
+	// Lemire's multiply-shift, rejecting the few values that would bias the low end
+	uint64_t product = uint64_t(next()) * range;
+	uint32_t leftover = uint32_t(product);
+	if (leftover < range) {
+		uint32_t threshold = (~range + 1u) % range;
+		while (leftover < threshold) {
+			product = uint64_t(next()) * range;
+			leftover = uint32_t(product);
+		}
+	}
+	return int(int64_t(low) + int64_t(product >> 32));
+}
+
+RandomService::RandomService(uint64_t seed) : seed(seed) {
+	for (int i = 0; i < int(RNG_STREAM::_count); ++i) {
+		streams[i] = RandomStream(deriveSeed(seed, i), i);
+	}
+}
+
+uint64_t RandomService::deriveSeed(const uint64_t& seed, const uint64_t& key) {
+	return splitMix(splitMix(seed) ^ key);
+}
+
+uint64_t RandomService::seedFromEntropy() {
+	std::random_device rd;
+	return (uint64_t(rd()) << 32) | rd();
+}
@@ -0,0 +1,113 @@
+#include "GameCore.h"
+#include <fstream>
+#include <algorithm>
+
+static const char replayMagic[4] = { 'C', 'R', 'R', 'P' };
+static const uint8_t endMarker = 0xFF; // Never a valid PLAYER_ACTION
+
+// Fixed little endian, so logs move between machines
+static void writeNumber(std::ofstream& out, uint64_t value, const int& bytes) {
+	for (int i = 0; i < bytes; ++i) {
+		out.put(char(value & 0xFF));
+		value >>= 8;
+	}
+}
+
+static bool readNumber(std::ifstream& in, uint64_t& value, const int& bytes) {
+	value = 0;
+	for (int i = 0; i < bytes; ++i) {
+		int byte = in.get();
+		if (byte == EOF) {
+			return false;
+		}
+		value |= uint64_t(byte) << (8 * i);
+	}
+	return true;
+}
+
+bool ReplayLog::startRecording(const std::string& path) {
+	this->out.open(path, std::ios::binary | std::ios::trunc);
+	if (!this->out) {
+		return false;
+	}
+	this->out.write(replayMagic, sizeof(replayMagic));
+	this->out.put(char(version));
+	writeNumber(this->out, this->seed, 8);
+	writeNumber(this->out, uint64_t(this->width), 4);
+	writeNumber(this->out, uint64_t(this->height), 4);
+	for (auto& action : this->actions) { // Whatever happened before a saved game was loaded
+		this->out.put(char(action));
+	}
+	this->out.flush();
+	return true;
+}
+
+void ReplayLog::record(const PLAYER_ACTION& action) {
+	this->actions.push_back(action);
+	if (this->out.is_open()) {
+		this->out.put(char(action));
+		this->out.flush();
+	}
+}
+
+void ReplayLog::finishRecording(const uint64_t& stateHash) {
+	this->hasFinalState = true;
+	this->finalHash = stateHash;
+	if (this->out.is_open()) {
+		this->out.put(char(endMarker));
+		writeNumber(this->out, this->actions.size(), 4);
+		writeNumber(this->out, stateHash, 8);
+		this->out.close();
+	}
+}
+
+bool ReplayLog::load(const std::string& path) {
+	std::ifstream in(path, std::ios::binary);
+	char magic[4];
+	if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, replayMagic)) {
+		return false;
+	}
+	int fileVersion = in.get();
+	if (fileVersion != 1 && fileVersion != version) {
+		return false;
+	}
+	if (!readNumber(in, this->seed, 8)) {
+		return false;
+	}
+	this->width = PLAY_AREA_WIDTH;
+	this->height = PLAY_AREA_HEIGHT;
+	if (fileVersion >= 2) {
+		uint64_t width, height;
+		if (!readNumber(in, width, 4) || !readNumber(in, height, 4)) {
+			return false;
+		}
+		this->width = int(width);
+		this->height = int(height);
+	}
+	this->actions.clear();
+	this->hasFinalState = false;
+	int byte;
+	while ((byte = in.get()) != EOF) {
+		if (byte == endMarker) {
+			uint64_t count;
+			if (!readNumber(in, count, 4) || !readNumber(in, this->finalHash, 8) || count != this->actions.size()) {
+				return false;
+			}
+			this->hasFinalState = true;
+			break;
+		}
+		if (byte > int(PLAYER_ACTION::INTERRACT)) {
+			return false;
+		}
+		this->actions.push_back(PLAYER_ACTION(byte));
+	}
+	return true; // Without the end marker this is a session that never closed - still worth replaying, there is just nothing to check against
+}
+
+void ReplayLog::play(Simulation& simulation) const {
+	std::vector<GameEvent> events; // Nobody reads them, but taking them into the same buffer every turn saves an allocation
+	for (auto& action : this->actions) {
+		simulation.step(action);
+		simulation.takeEvents(events);
+	}
+}
@@ -1,18 +1,16 @@
-#include "GameState.h"
-#include "libtcod.hpp"
-#include "SDL.h"
+#include "GameCore.h"
 
-void RoomGenerator::generateSafeRoom(Room& room) {
-	createWall(room, { room.center[0] + room.diameter, room.center[1] - room.diameter }, { room.center[0] + room.diameter, room.center[1] + room.diameter }, true);
-	createWall(room, { room.center[0] - room.diameter, room.center[1] + room.diameter }, { room.center[0] + room.diameter, room.center[1] + room.diameter }, true);
-	createWall(room, { room.center[0] - room.diameter, room.center[1] - room.diameter }, { room.center[0] + room.diameter, room.center[1] - room.diameter }, true);
-	createWall(room, { room.center[0] - room.diameter, room.center[1] - room.diameter }, { room.center[0] - room.diameter, room.center[1] + room.diameter }, true);
+void RoomGenerator::generateSafeRoom(Room& room, RandomStream& rng) {
+	createWall(room, { room.center[0] + room.diameter, room.center[1] - room.diameter }, { room.center[0] + room.diameter, room.center[1] + room.diameter }, true, rng);
+	createWall(room, { room.center[0] - room.diameter, room.center[1] + room.diameter }, { room.center[0] + room.diameter, room.center[1] + room.diameter }, true, rng);
+	createWall(room, { room.center[0] - room.diameter, room.center[1] - room.diameter }, { room.center[0] + room.diameter, room.center[1] - room.diameter }, true, rng);
+	createWall(room, { room.center[0] - room.diameter, room.center[1] - room.diameter }, { room.center[0] - room.diameter, room.center[1] + room.diameter }, true, rng);
 	room.pickupPositions.push_back(room.center);
 }
 
-void RoomGenerator::generateDisjointRoom(Room& room) {
-	createWall(room, { room.center[0] + room.diameter/2, room.center[1] - room.diameter/2 }, { room.center[0] + room.diameter/2, room.center[1] + room.diameter/2 }, false);
-	createWall(room, { room.center[0] - room.diameter, room.center[1] - room.diameter }, { room.center[0] - room.diameter, room.center[1] + room.diameter }, true);
+void RoomGenerator::generateDisjointRoom(Room& room, RandomStream& rng) {
+	createWall(room, { room.center[0] + room.diameter/2, room.center[1] - room.diameter/2 }, { room.center[0] + room.diameter/2, room.center[1] + room.diameter/2 }, false, rng);
+	createWall(room, { room.center[0] - room.diameter, room.center[1] - room.diameter }, { room.center[0] - room.diameter, room.center[1] + room.diameter }, true, rng);
 	room.actorPositions.push_back({ room.center[0] + room.diameter, room.center[1] - room.diameter });
 	room.actorPositions.push_back({ room.center[0] - room.diameter, room.center[1] - room.diameter });
 	room.pickupPositions.push_back(room.center);
@@ -63,11 +61,11 @@ void RoomGenerator::generateCorridorRoom(Room& room, Room& from, Room& to, bool
 	// Shut up
 }
 
-void RoomGenerator::createWall(Room& room, const std::array<int, 2>& from, const std::array<int, 2>& to, const bool& hasExit) {
+void RoomGenerator::createWall(Room& room, const std::array<int, 2>& from, const std::array<int, 2>& to, const bool& hasExit, RandomStream& rng) {
 	int wallLength = abs(from[0] - to[0]) + abs(from[1] - to[1]);
 	int exitPoint = -1;
 	if (hasExit) {
-		exitPoint = getRandomNumber(1, wallLength - 1); // Place the exit at random location along the wall
+		exitPoint = rng.getNumber(1, wallLength - 1); // Place the exit at random location along the wall
 	}
 	if (abs(from[0] - to[0]) == 0) { // Wall is horizontal
 		for (int i = 0; i <= wallLength; ++i) {
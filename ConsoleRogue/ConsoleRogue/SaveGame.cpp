@@ -0,0 +1,213 @@
+#include "GameState.h"
+#include "libtcod.hpp"
+#include <string>
+#include <vector>
+
+// TCODZip is deprecated upstream, but it is the compressor the bundled libtcod has - and /sdl turns the warning into an error
+#if defined(_MSC_VER)
+#pragma warning(disable : 4996)
+#elif defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#endif
+
+static const int saveMagic = 0x56535243; // "CRSV"
+
+// TCODZip only knows 32 bit ints
+static void putNumber(TCODZip& zip, const uint64_t& value) {
+	zip.putInt(int(uint32_t(value)));
+	zip.putInt(int(uint32_t(value >> 32)));
+}
+
+static uint64_t getNumber(TCODZip& zip) {
+	uint64_t low = uint32_t(zip.getInt());
+	uint64_t high = uint32_t(zip.getInt());
+	return low | (high << 32);
+}
+
+static void putActor(TCODZip& zip, const Actor& actor) {
+	zip.putInt(int(actor.type));
+	zip.putInt(actor.position[0]);
+	zip.putInt(actor.position[1]);
+	zip.putChar(actor.status);
+	zip.putInt(actor.health);
+	zip.putInt(actor.maxHealth);
+	zip.putInt(actor.speed);
+	zip.putInt(actor.speedLimit);
+	zip.putInt(actor.damage);
+	zip.putInt(actor.armor);
+	zip.putInt(actor.range);
+}
+
+static void getActor(TCODZip& zip, Actor& actor) {
+	actor.type = ACTOR_TYPE(zip.getInt());
+	actor.position[0] = zip.getInt();
+	actor.position[1] = zip.getInt();
+	actor.status = zip.getChar();
+	actor.health = zip.getInt();
+	actor.maxHealth = zip.getInt();
+	actor.speed = zip.getInt();
+	actor.speedLimit = zip.getInt();
+	actor.damage = zip.getInt();
+	actor.armor = zip.getInt();
+	actor.range = zip.getInt();
+}
+
+static bool isOnMap(const GameSnapshot& snapshot, const int& x, const int& y) {
+	return x >= 0 && x < snapshot.width && y >= 0 && y < snapshot.height;
+}
+
+static void putChunkIndices(TCODZip& zip, const std::vector<int>& indices) {
+	zip.putInt(int(indices.size()));
+	for (auto& index : indices) {
+		zip.putInt(index);
+	}
+}
+
+// Each index has to be a chunk of the map, and only come up once
+static bool getChunkIndices(TCODZip& zip, std::vector<int>& indices, const int& chunkCount) {
+	int count = zip.getInt();
+	if (count < 0 || count > chunkCount) {
+		return false;
+	}
+	std::vector<bool> used(chunkCount, false);
+	indices.clear();
+	for (int i = 0; i < count; ++i) {
+		int index = zip.getInt();
+		if (index < 0 || index >= chunkCount || used[index]) {
+			return false;
+		}
+		used[index] = true;
+		indices.push_back(index);
+	}
+	return true;
+}
+
+// getData reports how much was stored - anything else than expected means the file is no good
+template <typename T>
+static bool getArray(TCODZip& zip, std::vector<T>& values, const size_t& count) {
+	values.resize(count);
+	int bytes = int(count * sizeof(T));
+	return zip.getData(bytes, values.data()) == bytes;
+}
+
+bool SaveGame::write(const std::string& path, const GameSnapshot& snapshot, const EventLog& eventLog, const std::vector<PLAYER_ACTION>& actions) {
+	TCODZip zip;
+	zip.putInt(saveMagic);
+	zip.putInt(version);
+	putNumber(zip, snapshot.runSeed);
+	zip.putInt(snapshot.difficultyLevel);
+	zip.putInt(int(snapshot.status));
+	putActor(zip, snapshot.player);
+	zip.putInt(snapshot.player.sightRadius);
+	zip.putInt(snapshot.width);
+	zip.putInt(snapshot.height);
+	putChunkIndices(zip, snapshot.tileChunks);
+	zip.putData(int(snapshot.tiles.size()), snapshot.tiles.data());
+	putChunkIndices(zip, snapshot.sightChunks);
+	zip.putData(int(snapshot.visible.size() * sizeof(uint32_t)), snapshot.visible.data());
+	zip.putData(int(snapshot.seen.size() * sizeof(uint32_t)), snapshot.seen.data());
+	zip.putInt(int(snapshot.pickups.size()));
+	for (auto& pickup : snapshot.pickups) {
+		zip.putInt(int(pickup.type));
+		zip.putInt(pickup.position[0]);
+		zip.putInt(pickup.position[1]);
+	}
+	zip.putInt(int(snapshot.enemies.size()));
+	for (auto& enemy : snapshot.enemies) {
+		putActor(zip, enemy);
+	}
+	zip.putInt(eventLog.size());
+	for (int i = 0; i < eventLog.size(); ++i) {
+		zip.putInt(int(eventLog[i].message));
+		zip.putInt(eventLog[i].argument);
+	}
+	zip.putInt(int(actions.size()));
+	std::vector<char> actionBytes;
+	for (auto& action : actions) {
+		actionBytes.push_back(char(action));
+	}
+	zip.putData(int(actionBytes.size()), actionBytes.data());
+	return zip.saveToFile(path.c_str()) > 0;
+}
+
+bool SaveGame::read(const std::string& path, GameSnapshot& snapshot, EventLog& eventLog, std::vector<PLAYER_ACTION>& actions) {
+	TCODZip zip;
+	if (zip.loadFromFile(path.c_str()) == 0 || zip.getInt() != saveMagic || zip.getInt() != version) {
+		return false;
+	}
+	snapshot.runSeed = getNumber(zip);
+	snapshot.difficultyLevel = zip.getInt();
+	snapshot.status = GAME_STATUS(zip.getInt());
+	getActor(zip, snapshot.player);
+	snapshot.player.sightRadius = zip.getInt();
+	snapshot.width = zip.getInt();
+	snapshot.height = zip.getInt();
+	if (snapshot.width < MIN_MAP_SIZE || snapshot.width > MAX_MAP_SIZE || snapshot.height < MIN_MAP_SIZE || snapshot.height > MAX_MAP_SIZE ||
+		!isOnMap(snapshot, snapshot.player.position[0], snapshot.player.position[1])) {
+		return false;
+	}
+	int chunkCount = ((snapshot.width + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE) * ((snapshot.height + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE);
+	if (!getChunkIndices(zip, snapshot.tileChunks, chunkCount) ||
+		!getArray(zip, snapshot.tiles, snapshot.tileChunks.size() * MAP_CHUNK_SIZE * MAP_CHUNK_SIZE) ||
+		!getChunkIndices(zip, snapshot.sightChunks, chunkCount) ||
+		!getArray(zip, snapshot.visible, snapshot.sightChunks.size() * MAP_CHUNK_SIZE) ||
+		!getArray(zip, snapshot.seen, snapshot.sightChunks.size() * MAP_CHUNK_SIZE)) {
+		return false;
+	}
+	int pickupCount = zip.getInt();
+	if (pickupCount < 0 || pickupCount > snapshot.width * snapshot.height) {
+		return false;
+	}
+	snapshot.pickups.clear();
+	for (int i = 0; i < pickupCount; ++i) {
+		int type = zip.getInt();
+		int x = zip.getInt();
+		int y = zip.getInt();
+		if (type < 0 || type >= int(PICKUP_TYPE::_count) || !isOnMap(snapshot, x, y)) {
+			return false;
+		}
+		snapshot.pickups.push_back(Pickup(PICKUP_TYPE(type), { x, y }));
+	}
+	int enemyCount = zip.getInt();
+	if (enemyCount < 0 || enemyCount > snapshot.width * snapshot.height) {
+		return false;
+	}
+	snapshot.enemies.assign(enemyCount, Actor());
+	for (auto& enemy : snapshot.enemies) {
+		getActor(zip, enemy);
+		// Speed is the energy the enemy has built up, which never reaches its limit - and a dead enemy wouldn't have been saved
+		if (!isOnMap(snapshot, enemy.position[0], enemy.position[1]) || int(enemy.type) < 0 || int(enemy.type) >= int(ACTOR_TYPE::_count) ||
+			enemy.speedLimit <= 0 || enemy.speed < 0 || enemy.speed >= enemy.speedLimit || enemy.health < 1) {
+			return false;
+		}
+	}
+	int eventCount = zip.getInt();
+	if (eventCount < 0 || eventCount > EventLog::capacity) {
+		return false;
+	}
+	eventLog.clear();
+	for (int i = 0; i < eventCount; ++i) {
+		int message = zip.getInt();
+		int argument = zip.getInt();
+		if (message < 0 || message >= int(LOG_MESSAGE::_count)) {
+			return false;
+		}
+		eventLog.add({ LOG_MESSAGE(message), argument });
+	}
+	int actionCount = zip.getInt();
+	if (actionCount < 0) {
+		return false;
+	}
+	std::vector<char> actionBytes(actionCount);
+	if (zip.getData(actionCount, actionBytes.data()) != actionCount) {
+		return false;
+	}
+	actions.clear();
+	for (auto& action : actionBytes) {
+		if (action < 0 || action > char(PLAYER_ACTION::INTERRACT)) {
+			return false;
+		}
+		actions.push_back(PLAYER_ACTION(action));
+	}
+	return true;
+}
@@ -0,0 +1,202 @@
+#include "GameCore.h"
+#include <vector>
+#include <algorithm>
+
+Simulation::Simulation(const uint64_t& seed, const int& width, const int& height, FLOOR_GENERATION floorGeneration) : playArea(seed, width, height, floorGeneration), player(new Player()), status(GAME_STATUS::RUNNING), profiler(nullptr) {
+	playArea.setupNewPlayArea(*player);
+	player->recalculateActiveSight(playArea);
+}
+
+void Simulation::step(PLAYER_ACTION action) {
+	if (this->status != GAME_STATUS::RUNNING) {
+		return; // The run is over, nothing left to simulate
+	}
+	switch (action) {
+	case PLAYER_ACTION::MOVE_UP:
+		this->playerMove(DIRECTIONS::MOVE_UP);
+		break;
+	case PLAYER_ACTION::MOVE_DOWN:
+		this->playerMove(DIRECTIONS::MOVE_DOWN);
+		break;
+	case PLAYER_ACTION::MOVE_LEFT:
+		this->playerMove(DIRECTIONS::MOVE_LEFT);
+		break;
+	case PLAYER_ACTION::MOVE_RIGHT:
+		this->playerMove(DIRECTIONS::MOVE_RIGHT);
+		break;
+	case PLAYER_ACTION::INTERRACT:
+		this->playerInterract();
+		break;
+	}
+}
+
+std::vector<GameEvent> Simulation::takeEvents() {
+	std::vector<GameEvent> taken;
+	taken.swap(this->events);
+	return taken;
+}
+
+void Simulation::takeEvents(std::vector<GameEvent>& taken) {
+	taken.clear();
+	taken.swap(this->events);
+}
+
+// FNV-1a over everything that decides how the run continues
+uint64_t Simulation::stateHash() const {
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](const int64_t& value) {
+		for (int i = 0; i < 8; ++i) {
+			hash ^= uint64_t(value >> (8 * i)) & 0xFF;
+			hash *= 1099511628211ull;
+		}
+	};
+	mix(int(this->status));
+	mix(this->playArea.level->difficultyLevel);
+	mix(this->player->position[0]);
+	mix(this->player->position[1]);
+	mix(this->player->health);
+	mix(this->player->maxHealth);
+	mix(this->player->speed);
+	mix(this->player->damage);
+	mix(this->player->armor);
+	mix(this->player->range);
+	for (int x = 0; x < this->playArea.width; ++x) {
+		for (int y = 0; y < this->playArea.height; ++y) {
+			mix(this->playArea.tileAt(x, y));
+		}
+	}
+	const ActorTable& enemies = this->playArea.level->hostileActors;
+	for (int i = 0; i < enemies.size(); ++i) { // Not the ids - a restored game hands them out anew
+		mix(enemies.positionX[i]);
+		mix(enemies.positionY[i]);
+		mix(enemies.health[i]);
+		mix(enemies.energyAt(i, this->playArea.level->turns.now()));
+	}
+	return hash;
+}
+
+GameSnapshot Simulation::snapshot() const {
+	GameSnapshot snapshot;
+	snapshot.runSeed = this->playArea.runSeed;
+	snapshot.difficultyLevel = this->playArea.level->difficultyLevel;
+	snapshot.status = this->status;
+	snapshot.player = *this->player;
+	snapshot.width = this->playArea.width;
+	snapshot.height = this->playArea.height;
+	this->playArea.tiles.exportChunks(snapshot.tileChunks, snapshot.tiles);
+	this->playArea.visibility.exportChunks(snapshot.sightChunks, snapshot.visible, snapshot.seen);
+	for (auto& pickup : this->playArea.level->pickups) {
+		snapshot.pickups.push_back(*pickup);
+	}
+	const ActorTable& enemies = this->playArea.level->hostileActors;
+	for (int i = 0; i < enemies.size(); ++i) {
+		snapshot.enemies.push_back(enemies.get(i, this->playArea.level->turns.now()));
+	}
+	return snapshot;
+}
+
+void Simulation::restore(const GameSnapshot& snapshot) {
+	this->playArea.runSeed = snapshot.runSeed;
+	this->playArea.setSize(snapshot.width, snapshot.height);
+	this->playArea.generateNewLevel(snapshot.difficultyLevel); // The same rooms as before, but fresh enemies and pickups
+	Level& level = *this->playArea.level;
+	level.clearEntities();
+	for (auto& pickup : snapshot.pickups) {
+		level.spawnPickup(pickup.type, pickup.position);
+	}
+	for (auto& enemy : snapshot.enemies) {
+		level.spawnEnemy(enemy);
+	}
+	this->playArea.tiles.importChunks(snapshot.tileChunks, snapshot.tiles); // setSize() left both empty
+	this->playArea.visibility.importChunks(snapshot.sightChunks, snapshot.visible, snapshot.seen);
+	++this->playArea.terrainVersion;
+	this->playArea.markAllDirty();
+	*this->player = snapshot.player;
+	this->status = snapshot.status;
+	this->events.clear();
+}
+
+void Simulation::playerMove(DIRECTIONS direction) {
+	{
+		ProfileScope movement(this->profiler, TURN_PHASE::MOVEMENT);
+		switch (direction) {
+		case DIRECTIONS::MOVE_DOWN:
+			this->player->placeSelf(this->playArea, this->player->position[0], this->player->position[1] + 1);
+			break;
+		case DIRECTIONS::MOVE_UP:
+			this->player->placeSelf(this->playArea, this->player->position[0], this->player->position[1] - 1);
+			break;
+		case DIRECTIONS::MOVE_LEFT:
+			this->player->placeSelf(this->playArea, this->player->position[0] - 1, this->player->position[1]);
+			break;
+		case DIRECTIONS::MOVE_RIGHT:
+			this->player->placeSelf(this->playArea, this->player->position[0] + 1, this->player->position[1]);
+			break;
+		}
+		this->events.push_back({ GAME_EVENT_TYPE::PLAYER_MOVED, int(direction) });
+	}
+	this->endTurn();
+}
+
+void Simulation::playerInterract() {
+	Level& level = *this->playArea.level;
+	int x = this->player->position[0];
+	int y = this->player->position[1];
+	{
+		ProfileScope interraction(this->profiler, TURN_PHASE::MOVEMENT);
+		int enemy = level.nearestVisibleEnemy(this->playArea, x, y, this->player->range);
+		if (enemy != -1) { // Attacking takes precedence over picking things up
+			int slot = level.hostileActors.slotOf(enemy);
+			level.hostileActors.health[slot] -= this->player->damage - (level.hostileActors.armor[slot] / 2);
+			this->events.push_back({ GAME_EVENT_TYPE::ENEMY_DAMAGED, this->player->damage - (level.hostileActors.armor[slot] / 2) });
+			if (level.hostileActors.health[slot] < 1) { // Actor was killed
+				this->events.push_back({ GAME_EVENT_TYPE::ENEMY_KILLED, int(level.hostileActors.type[slot]) });
+				level.killEnemy(this->playArea, enemy);
+			}
+		}
+		else if (Pickup* pickup = level.nearestVisiblePickup(this->playArea, x, y, this->player->range)) {
+			this->player->playerInterract(*pickup);
+			this->events.push_back({ GAME_EVENT_TYPE::PICKUP_COLLECTED, int(pickup->type) });
+			if (pickup->type == PICKUP_TYPE::EXIT) { // Player found and entered the exit
+				this->setupNewFloor();
+				return;
+			}
+			level.removePickup(this->playArea, pickup); // Pickups are one-time use only
+		}
+	}
+	this->endTurn(); // Only one interraction per action premitted
+}
+
+void Simulation::setupNewFloor() {
+	this->playArea.generateNewLevel(this->playArea.level->difficultyLevel + 1);
+	this->events.push_back({ GAME_EVENT_TYPE::FLOOR_ENTERED, this->playArea.level->difficultyLevel });
+	if (this->playArea.level->difficultyLevel >= WINNING_FLOOR) {
+		this->status = GAME_STATUS::WON;
+		this->events.push_back({ GAME_EVENT_TYPE::PLAYER_WON, this->playArea.level->difficultyLevel });
+		return;
+	}
+	this->playArea.setupNewPlayArea(*this->player);
+	this->player->recalculateActiveSight(this->playArea);
+}
+
+void Simulation::endTurn() {
+	{
+		ProfileScope vision(this->profiler, TURN_PHASE::FIELD_OF_VIEW);
+		this->player->recalculateActiveSight(this->playArea); // Enemies go by what the player sees after the action
+	}
+	int moved;
+	{
+		ProfileScope enemies(this->profiler, TURN_PHASE::ENEMIES);
+		moved = this->playArea.level->updateEnemies(this->playArea, *this->player, this->events);
+	}
+	if (this->player->health < 1) {
+		this->status = GAME_STATUS::DIED;
+		this->events.push_back({ GAME_EVENT_TYPE::PLAYER_DIED, 0 });
+		return;
+	}
+	this->playArea.drawEnemies(); // Enemies may have moved
+	if (moved > 0) { // Goblins block sight, so the cells they left and stepped into may have changed what the player sees
+		ProfileScope vision(this->profiler, TURN_PHASE::FIELD_OF_VIEW);
+		this->player->recalculateActiveSight(this->playArea);
+	}
+}
@@ -0,0 +1,35 @@
+#include "GameCore.h"
+#include <algorithm>
+
+TurnProfiler::TurnProfiler() : frames(0) {
+	for (auto& phase : history) {
+		phase.fill(0);
+	}
+	current.fill(0);
+}
+
+void TurnProfiler::finishFrame() {
+	for (int phase = 0; phase < int(TURN_PHASE::_count); ++phase) {
+		history[phase][frames % historyLength] = current[phase];
+	}
+	current.fill(0);
+	++frames;
+}
+
+long long TurnProfiler::last(const TURN_PHASE& phase) const {
+	if (frames == 0) {
+		return 0;
+	}
+	return history[int(phase)][(frames - 1) % historyLength];
+}
+
+long long TurnProfiler::percentile99(const TURN_PHASE& phase) const {
+	int count = std::min(frames, historyLength);
+	if (count == 0) {
+		return 0;
+	}
+	std::array<long long, historyLength> sorted = history[int(phase)];
+	int index = (count * 99) / 100;
+	std::nth_element(sorted.begin(), sorted.begin() + index, sorted.begin() + count);
+	return sorted[index];
+}
@@ -0,0 +1,21 @@
+#include "GameCore.h"
+#include <algorithm>
+
+void TurnScheduler::schedule(const int& id, const int64_t& time) {
+	this->queue.push_back({ time, id });
+	std::push_heap(this->queue.begin(), this->queue.end(), isLater);
+}
+
+bool TurnScheduler::popDue(const int64_t& until, int& id) {
+	if (this->queue.empty() || this->queue.front().time > until) {
+		return false;
+	}
+	id = this->queue.front().id;
+	std::pop_heap(this->queue.begin(), this->queue.end(), isLater);
+	this->queue.pop_back();
+	return true;
+}
+
+void TurnScheduler::clear() {
+	this->queue.clear();
+}
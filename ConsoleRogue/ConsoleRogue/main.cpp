@@ -2,40 +2,156 @@
 #include "SDL.h"
 #include "GameState.h"
 #include <iostream>
+#include <chrono>
+#include <cstring>
 // SDL defines main and causes errors
 #undef main
 
-int main() {
+// SDL_PollEvent, with the time it takes counted as input handling
+static bool pollEvent(Game* gameState, SDL_Event& event) {
+    ProfileScope input(gameState->getProfiler(), TURN_PHASE::INPUT);
+    return SDL_PollEvent(&event);
+}
+
+// Plays a recorded session back without a window and checks it ends the same way
+static int replaySession(const char* path) {
+    ReplayLog replay;
+    if (!replay.load(path)) {
+        std::cerr << "Not a replay: " << path << std::endl;
+        return 1;
+    }
+    Simulation simulation(replay.seed, replay.width, replay.height, FLOOR_GENERATION::ON_CALLING_THREAD);
+    auto start = std::chrono::steady_clock::now();
+    replay.play(simulation);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << replay.actions.size() << " actions in " << seconds << " s" << std::endl;
+    if (!replay.hasFinalState) {
+        std::cout << "The session was never closed, nothing to check the result against" << std::endl;
+        return 0;
+    }
+    if (simulation.stateHash() != replay.finalHash) {
+        std::cout << "Replay diverged from the recorded session" << std::endl;
+        return 2;
+    }
+    std::cout << "Replay matches the recorded session" << std::endl;
+    return 0;
+}
+
+// Bot games without a window, one line per game - with 0 games it keeps going until killed
+// Each game is recorded over the last one, so a crash leaves a replay of exactly the game that crashed
+static int playHeadless(const int& games, const char* recordPath, const int& width, const int& height) {
+    std::vector<GameEvent> events; // Nobody reads them, the buffer is only reused
+    for (int game = 0; games == 0 || game < games; ++game) {
+        uint64_t seed = RandomService::seedFromEntropy();
+        Simulation simulation(seed, width, height, FLOOR_GENERATION::ON_CALLING_THREAD);
+        AutoPlayer bot;
+        ReplayLog replay(seed, width, height);
+        replay.startRecording(recordPath);
+        int turns = 0;
+        while (simulation.status == GAME_STATUS::RUNNING) {
+            PLAYER_ACTION action = bot.chooseAction(simulation);
+            replay.record(action);
+            simulation.step(action);
+            simulation.takeEvents(events);
+            ++turns;
+        }
+        replay.finishRecording(simulation.stateHash());
+        std::cout << "seed " << seed << ": " << (simulation.status == GAME_STATUS::WON ? "won" : "died") << " on floor "
+            << simulation.playArea.level->difficultyLevel << " after " << turns << " turns" << std::endl;
+    }
+    return 0;
+}
+
+// --record <file> writes the session somewhere other than last_session.replay, --replay <file> plays one back headless
+// --bot lets the AutoPlayer play, --headless does so without a window for --games <n> games
+// --new starts a fresh run instead of continuing the autosave
+// --width <n> and --height <n> pick the size of the map for new runs, the screen shows as much of it as fits around the player
+int main(int argc, char* argv[]) {
+    const char* recordPath = "last_session.replay";
+    bool bot = false;
+    bool headless = false;
+    bool newRun = false;
+    int games = 1;
+    int width = PLAY_AREA_WIDTH;
+    int height = PLAY_AREA_HEIGHT;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--replay") == 0 && hasValue) {
+            return replaySession(argv[i + 1]);
+        }
+        if (strcmp(argv[i], "--record") == 0 && hasValue) {
+            recordPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--games") == 0 && hasValue) {
+            games = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--width") == 0 && hasValue) {
+            width = std::clamp(atoi(argv[++i]), MIN_MAP_SIZE, MAX_MAP_SIZE);
+        }
+        else if (strcmp(argv[i], "--height") == 0 && hasValue) {
+            height = std::clamp(atoi(argv[++i]), MIN_MAP_SIZE, MAX_MAP_SIZE);
+        }
+        else if (strcmp(argv[i], "--bot") == 0) {
+            bot = true;
+        }
+        else if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        }
+        else if (strcmp(argv[i], "--new") == 0) {
+            newRun = true;
+        }
+    }
+    if (headless) {
+        return playHeadless(games, recordPath, width, height);
+    }
     Palette* palette = new Palette();
-    Game* gameState = new Game(std::make_shared<Palette> (*palette));
+    Game* gameState = new Game(std::make_shared<Palette> (*palette), RandomService::seedFromEntropy(), width, height);
+    if (!newRun) {
+        gameState->loadGame(AUTOSAVE_FILE); // Nothing to load is fine, that's just a new run. A loaded run keeps the size it was saved with
+    }
+    if (!gameState->startRecording(recordPath)) {
+        std::cerr << "Could not record the session to " << recordPath << std::endl;
+    }
+    AutoPlayer autoPlayer;
     while (1) {  // Game loop.
         // TCOD_console_clear(console.get());
         SDL_Event event;
-        SDL_WaitEvent(nullptr);  // Optional, sleep until events are available.
-        while (SDL_PollEvent(&event)) {
+        bool botPlaying = bot && gameState->getSimulation().status == GAME_STATUS::RUNNING;
+        if (!botPlaying) {
+            SDL_WaitEvent(nullptr);  // Optional, sleep until events are available.
+        }
+        while (pollEvent(gameState, event)) {
             switch (event.type) {
             case SDL_QUIT:
+                gameState->endSession();
                 return 0;  // Exit.
             case SDL_KEYDOWN:
                 switch (event.key.keysym.sym) {
                 case SDLK_RIGHT:
-                    gameState->playerMove(DIRECTIONS::MOVE_RIGHT);
+                    gameState->playerAction(PLAYER_ACTION::MOVE_RIGHT);
                     break;
                 case SDLK_UP:
-                    gameState->playerMove(DIRECTIONS::MOVE_UP);
+                    gameState->playerAction(PLAYER_ACTION::MOVE_UP);
                     break;
                 case SDLK_LEFT:
-                    gameState->playerMove(DIRECTIONS::MOVE_LEFT);
+                    gameState->playerAction(PLAYER_ACTION::MOVE_LEFT);
                     break;
                 case SDLK_DOWN:
-                    gameState->playerMove(DIRECTIONS::MOVE_DOWN);
+                    gameState->playerAction(PLAYER_ACTION::MOVE_DOWN);
                     break;
                 case SDLK_SPACE:
-                    gameState->playerInterract();
+                    gameState->playerAction(PLAYER_ACTION::INTERRACT);
+                    break;
+                case SDLK_F3:
+                    gameState->toggleProfilerOverlay();
                     break;
                 }
                 
             }
         }
+        if (botPlaying) { // One bot turn per frame, so it can be watched
+            gameState->playerAction(autoPlayer.chooseAction(gameState->getSimulation()));
+        }
+        gameState->presentFrame(); // Once for the whole batch of events
     }
 }
\ No newline at end of file